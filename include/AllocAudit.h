@@ -0,0 +1,41 @@
+// AllocAudit.h — heap allocation counter for the playback hot path.
+// Built with ALLOC_AUDIT (the alloc_audit environment), malloc/calloc/realloc
+// are wrapped at link time and every allocation made by the watched task is
+// counted. Allocations inside an FsAllocScope are booked to the filesystem
+// layer instead, since VFS/LittleFS allocate a handle on every open that the
+// application cannot avoid. In steady state the application count per frame
+// should read zero.
+// Without ALLOC_AUDIT everything here compiles to nothing.
+
+#ifndef ALLOC_AUDIT_H
+#define ALLOC_AUDIT_H
+
+#include <Arduino.h>
+
+class AllocAudit {
+public:
+#ifdef ALLOC_AUDIT
+    // Count allocations made from the calling task from now on.
+    static void watchCurrentTask();
+
+    // Allocations counted so far, outside / inside FsAllocScope.
+    static uint32_t appAllocs();
+    static uint32_t fsAllocs();
+
+    static void enterFs();
+    static void leaveFs();
+#else
+    static void watchCurrentTask() {}
+    static void enterFs() {}
+    static void leaveFs() {}
+#endif
+};
+
+// Books allocations made while in scope to the filesystem layer.
+class FsAllocScope {
+public:
+    FsAllocScope()  { AllocAudit::enterFs(); }
+    ~FsAllocScope() { AllocAudit::leaveFs(); }
+};
+
+#endif
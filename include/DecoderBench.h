@@ -0,0 +1,18 @@
+// DecoderBench.h — on-device JPEG decoder benchmark (bench_decoder env only).
+// Decodes frames already recorded in the LittleFS cache with every compiled-in
+// JpegDecoder backend and reports milliseconds per frame (decode and blit
+// separately) and the RAM each backend needs.
+
+#ifndef DECODER_BENCH_H
+#define DECODER_BENCH_H
+
+#ifdef DECODER_BENCH
+
+// Start the cache, decode up to DECODER_BENCH_FRAMES cached JPEGs
+// DECODER_BENCH_PASSES times with each backend, and print a report to Serial.
+// Needs no network. Call from setup() after initDisplay(); does not return.
+void runDecoderBench();
+
+#endif
+
+#endif
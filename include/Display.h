@@ -16,15 +16,42 @@ extern Arduino_GFX *gfx;
 // Must be called once from setup() before drawing anything.
 void initDisplay();
 
+// Serialise panel access between tasks. Arduino_GFX is not thread-safe, so
+// the playback engine holds this lock while drawing a frame and showStatus()
+// takes it for each line (e.g. when the sync task reconnects WiFi).
+void lockDisplay();
+void unlockDisplay();
+
 // Print a status line on screen during boot, advancing one line per call.
 // Intended for boot-time feedback only; satellite images overwrite it once running.
 // color is an RGB565 value — use WHITE (0xFFFF), GREEN (0x07E0), or RED (0xF800).
 void showStatus(const char *msg, uint16_t color = 0xFFFF);
 
-// TJpg_Decoder tile callback.
-// The decoder calls this once per 16×16 decoded block; this function forwards
-// the block to the display via gfx->draw16bitRGBBitmap().
+// Draw a row-major RGB565 block. A block inside the panel goes straight to
+// the board's bus and panel driver, bound at compile time (DISPLAY_DIRECT_BLIT;
+// see Display.cpp); anything else goes through gfx->draw16bitRGBBitmap().
+// Caller holds the display lock.
+void blitToPanel(int16_t x, int16_t y, uint16_t w, uint16_t h, uint16_t *bitmap);
+
+// Blocks blitToPanel() drew since the last call. With takeBlitMicros() this
+// gives the per-block cost of the output path.
+uint32_t takeBlitTiles();
+
+// JPEG decoder tile callback, shared by every backend (see JpegDecoder.h).
+// The decoder calls this once per decoded block (a 16×16 MCU for TJpgDec, a
+// run of MCUs for JPEGDEC); this function forwards the block to the display
+// via blitToPanel().
 // Returns true to continue decoding the rest of the JPEG.
 bool tft_output(int16_t x, int16_t y, uint16_t w, uint16_t h, uint16_t *bitmap);
 
+// Microseconds tft_output() spent inside the panel driver since the last call.
+// The playback engine reads this after each frame to split decode from blit time.
+uint32_t takeBlitMicros();
+
+// Optional observer of decoded tiles. When set, tft_output() passes every tile
+// to it before drawing, so the playback engine can transcode a frame to RLE
+// from the decode it is doing anyway. Pass nullptr to remove it.
+typedef void (*TileTap)(int16_t x, int16_t y, uint16_t w, uint16_t h, const uint16_t *bitmap);
+void setTileTap(TileTap tap);
+
 #endif
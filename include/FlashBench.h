@@ -0,0 +1,57 @@
+// FlashBench.h — LittleFS benchmark for the frame cache's access pattern.
+// Fills the filesystem to CACHE_FILL_THRESHOLD with frame-sized files and
+// times sequential writes (empty and full), open latency, sequential reads
+// and deletes. The same suite runs on the device (bench_flash envs) and on the
+// host over a modeled NOR flash (native_flash envs, src/host/FlashBenchMain.cpp),
+// so the LittleFS mount profile in platformio.ini can be tuned from data.
+
+#ifndef FLASH_BENCH_H
+#define FLASH_BENCH_H
+
+#if defined(FLASH_BENCH) || defined(NATIVE_FLASH_BENCH)
+
+#include <Arduino.h>
+
+// Timings of one kind of operation.
+struct FlashOpStats {
+    uint32_t count   = 0;
+    uint64_t totalUs = 0;
+    uint32_t minUs   = UINT32_MAX;
+    uint32_t maxUs   = 0;
+    uint64_t bytes   = 0;  // Payload moved, for throughput
+
+    void add(uint32_t us, size_t n = 0) {
+        count++;
+        totalUs += us;
+        bytes   += n;
+        minUs    = min(minUs, us);
+        maxUs    = max(maxUs, us);
+    }
+    float avgMs() const { return count ? totalUs / 1000.0f / count : 0.0f; }
+    float kBps()  const { return totalUs ? bytes * 1000000.0f / 1024.0f / totalUs : 0.0f; }
+};
+
+struct FlashBenchResult {
+    int          files = 0;  // Files written before reaching CACHE_FILL_THRESHOLD
+    FlashOpStats writeEmpty;  // The first files, on an empty filesystem
+    FlashOpStats writeFull;   // Writes once full, each after evicting the oldest file
+    FlashOpStats open;        // open() + close() of a cached file
+    FlashOpStats read;        // Whole-file sequential reads
+    FlashOpStats remove;      // Evictions on the full filesystem
+};
+
+// Run the suite on a mounted, freshly formatted LittleFS and print a report
+// to Serial. Leaves the filesystem full; format it afterwards. Returns false
+// if a filesystem operation failed.
+bool runFlashSuite(FlashBenchResult &result);
+
+#ifdef FLASH_BENCH
+// Format LittleFS (this erases the frame cache), run the suite, format again
+// and halt. Needs no network. Call from setup() after initDisplay(); does not
+// return.
+void runFlashBench();
+#endif
+
+#endif
+
+#endif
@@ -0,0 +1,89 @@
+// FrameCodec.h — display-native RLE RGB565 frame format.
+// A satellite frame is mostly the black of space plus the area outside the
+// Earth disk, so the decoded RGB565 image compresses well with plain
+// run-length encoding. Storing that instead of the JPEG turns playback into a
+// flash read plus run expansion straight into the panel — no JPEG decode.
+//
+// File layout (little-endian):
+//   RleHeader { magic "RL16", width, height, CRC32 of the payload }
+//   payload: a sequence of tokens covering width × height pixels row-major;
+//            runs may continue across row ends.
+//     0x8000 | n, pixel     — n copies of pixel   (run,     1 ≤ n ≤ 32767)
+//     n, pixel × n          — n literal pixels    (literal, 1 ≤ n ≤ 32767)
+// Pixels are native-endian RGB565, exactly as tft_output() receives them.
+//
+// Frames are transcoded by teeing the JPEG decoder's tile output the first
+// time a frame is shown (see Playback::drawSlot()), so producing the RLE copy
+// costs no extra decode.
+
+#ifndef FRAME_CODEC_H
+#define FRAME_CODEC_H
+
+#include <Arduino.h>
+
+struct RleHeader {
+    uint32_t magic;
+    uint16_t width;
+    uint16_t height;
+    uint32_t payloadCrc;
+};
+
+// True if data starts with an RLE frame header (cheap; no CRC check).
+bool isRleFrame(const uint8_t *data, size_t size);
+
+// Full check: header, dimensions, and payload CRC. Used on the first load of
+// a frame after boot, like the CRC check for JPEGs.
+bool verifyRleFrame(const uint8_t *data, size_t size);
+
+// Expand an RLE frame onto the display in RLE_BAND_LINES-high bands. The
+// caller holds the display lock. Adds the time spent in the panel driver to
+// *blitUs. Returns false if the frame is malformed or the wrong size; the
+// token stream is checked first, so nothing is drawn in that case.
+bool drawRleFrame(const uint8_t *data, size_t size, uint32_t *blitUs);
+
+// Streaming encoder fed with the JPEG decoder's tiles. Tiles arrive in MCU
+// order (left to right, one band of rows at a time); each completed band is
+// encoded and the band buffer reused, so only the compressed output grows.
+class RleEncoder {
+public:
+    // Start a frame of width × height. Returns false if no memory. A frame
+    // whose encoding outgrows RLE_MAX_INTERNAL_BYTES on a board without PSRAM
+    // is aborted and stays a JPEG.
+    bool begin(uint16_t width, uint16_t height);
+
+    // Tile callback input. Tiles taller than RLE_BAND_LINES or arriving out of
+    // order abort the frame.
+    void addTile(int16_t x, int16_t y, uint16_t w, uint16_t h, const uint16_t *bitmap);
+
+    // Finish the frame. On success hands over the encoded buffer (free() it)
+    // and its size; returns false if the frame was aborted.
+    bool finish(uint8_t **data, size_t *size);
+
+    // Drop the frame in progress and release its buffer.
+    void abort();
+
+    bool active() const { return out != nullptr; }
+
+private:
+    uint8_t  *out      = nullptr;  // Header + payload
+    size_t    outSize  = 0;
+    size_t    outCap   = 0;
+    size_t    outMax   = 0;        // Frame aborted if it would grow past this
+    uint16_t  width    = 0;
+    uint16_t  height   = 0;
+    int16_t   bandY    = -1;       // Top row of the band being collected
+    uint16_t  bandRows = 0;
+    uint16_t  runPixel = 0;
+    uint16_t  runLen   = 0;
+    size_t    litAt    = 0;        // Offset of the open literal's count word (0 = none)
+    uint16_t  litLen   = 0;
+
+    bool reserve(size_t extra);
+    void put16(uint16_t v);
+    void pushPixel(uint16_t px);
+    void closeRun();
+    void closeLiteral();
+    void flushBand();
+};
+
+#endif
@@ -4,58 +4,258 @@
 // cleanup routine identify the oldest frame without storing a separate index.
 // The satellite subdirectory prevents frames from different sources mixing when
 // SATTYPE is changed between builds.
+// A small frame index (/meta/<satellite>.idx) records the length and a CRC32
+// content hash per frame. The hash lets identical payloads — e.g. an unchanged
+// Meteosat "latest" image — be detected and not stored or shown twice; the
+// length + hash let truncated or corrupt frames be caught cheaply on load.
+// Frames are written to <timestamp>.tmp and renamed into place, so a power cut
+// mid-write never leaves a partial <timestamp>.jpg behind.
+// Each frame belongs to a quality tier: tier 0 is JPEG_QUALITY, tier 1 a
+// smaller CACHE_AGED_QUALITY copy that replaces frames once they are old and
+// flash is filling up (see ImageDownloader::demoteAgedFrames()).
+// With CACHE_RLE_FRAMES, a frame is replaced by a pre-decoded <timestamp>.rle
+// (see FrameCodec.h) after it has been shown once; the index records which
+// format each frame is stored in.
 
 #ifndef IMAGE_CACHE_H
 #define IMAGE_CACHE_H
 
 #include <Arduino.h>
 #include <LittleFS.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/semphr.h>
 #include "config.h"
 
+class Timeline;
+
+// Playback frame buffer, defined in main.cpp. loadImage() places the cached
+// JPEG here; only the playback engine (loop task) reads it.
+extern uint8_t *imageBuffer;
+extern size_t   imageSize;
+
+// A caller-owned load target. loadImage() grows data (in PSRAM if psram is
+// set) and never shrinks it; the owner frees it.
+struct FrameBuffer {
+    uint8_t *data;
+    size_t   capacity;
+    size_t   size;      // Length of the loaded frame
+    bool     psram;
+};
+
 class ImageCache {
 public:
-    // Mount LittleFS (auto-formatting if the first mount fails) and reset the
-    // in-memory ring buffer. Must be called once from setup() before any other
-    // cache methods. Returns true on success.
+    // Mount LittleFS (auto-formatting if the first mount fails), load the
+    // persisted frame index, and start the background writer task. Must be
+    // called once from setup() before any other cache methods. Returns true on success.
+    // The lock exists from the start of begin(), so the other methods are safe
+    // (and see an empty cache) even after it fails.
     bool begin();
 
-    // Write the current imageBuffer / imageSize to LittleFS under <timestamp>.jpg.
-    // If storage is at or above CACHE_FILL_THRESHOLD, evicts the oldest frame first.
-    // Returns true if the file was written successfully.
-    bool cacheImage(const String& timestamp);
+    // True once begin() has succeeded.
+    bool ready() const { return started; }
+
+    // Queue a copy of <data> (<size> bytes) to be written to
+    // LittleFS under <timestamp>.jpg by the writer task, which also records the
+    // content hash and quality tier in the frame index and evicts old frames
+    // when storage is at or above CACHE_FILL_THRESHOLD. An existing frame for
+    // <timestamp> is replaced once the new copy is on flash. Returns as soon as the copy is queued, so
+    // flash latency never reaches the caller. Blocks (backpressure) for up to
+    // CACHE_WRITE_QUEUE_WAIT_MS while the queue is full.
+    // Returns false if the frame could not be queued or written.
+    // The caller keeps ownership of data and may reuse it once this returns.
+    bool cacheImage(const char* timestamp, const uint8_t *data, size_t size, uint32_t hash,
+                    uint8_t tier);
+
+    // Queue an RLE transcode of an already cached tier-0 JPEG frame (aged
+    // frames stay JPEG — their point is to be small). The .rle file
+    // replaces the .jpg once written; the index keeps the JPEG's content hash
+    // so de-duplication is unaffected. Takes ownership of data (malloc'd) in
+    // every case. Never blocks: called from the playback loop, so if the frame
+    // is not indexed or the queue is full the transcode is dropped and simply
+    // retried the next time the frame is shown. Returns true if queued.
+    bool cacheTranscoded(const char* timestamp, uint8_t *data, size_t size);
+
+    // Streamed frames: the sync task writes a JPEG into the file returned by
+    // openStreamed() while it is still arriving, then moves it into place and
+    // indexes it with commitStreamed(), or deletes it with abortStreamed().
+    // This bypasses the writer task, since holding the whole frame in RAM to
+    // queue it is what streaming avoids. Check hasRoomFor() first: nothing is
+    // evicted to make room for a stream.
+    bool hasRoomFor(size_t bytes);
+    File openStreamed(const char* timestamp);
+    bool commitStreamed(const char* timestamp, size_t size, uint32_t hash);
+    void abortStreamed(const char* timestamp);
+
+    // Open the cached JPEG for <timestamp> for a LAN peer, if it is indexed
+    // at quality <tier> and stored as JPEG (an .rle frame is not shareable).
+    // Returns a closed File otherwise. <hash> receives the indexed content
+    // hash (0 if not yet known).
+    File openForPeer(const char* timestamp, uint8_t tier, uint32_t *hash);
+
+    // Block until every queued frame has been written, or timeoutMs elapses.
+    // Returns true if the queue drained. Also runs automatically from an
+    // esp_restart() shutdown handler so queued frames survive a soft reboot.
+    bool flush(uint32_t timeoutMs);
+
+    // Load the cached frame for <timestamp> into imageBuffer / imageSize —
+    // a JPEG, or an RLE frame if it has been transcoded (check isRleFrame()).
+    // Frames still waiting in the write queue are served from RAM.
+    // The file length is checked against the index on every load and the CRC32
+    // on the first load after boot (RLE frames carry their own payload CRC);
+    // frames without an index entry must at least
+    // start with SOI and end with EOI. A frame that fails is deleted so the next
+    // pass downloads it again. imageBuffer only grows, so in steady state a
+    // load allocates nothing. Returns false if not found or corrupt.
+    bool loadImage(const char* timestamp);
+
+    // Same, into a caller-owned buffer instead of imageBuffer. Safe to call
+    // from any task; the prefetch task uses it to fill its ring.
+    bool loadImage(const char* timestamp, FrameBuffer& buf);
+
+    // CRC32 of a JPEG payload. Used as the content hash in the frame index.
+    static uint32_t contentHash(const uint8_t *data, size_t size);
+
+    // True if a frame for <timestamp> is indexed or waiting in the write queue.
+    // Index lookup only — no flash access.
+    bool contains(const char* timestamp);
+
+    // contains() for every slot of <timeline> at once, as a bitmap: bit i of
+    // <bits> (count() bits, LSB first) is set if slot i is cached. One lock
+    // hold, so the playback engine can walk the whole window each tick.
+    void cachedSlots(const Timeline& timeline, uint8_t *bits);
+
+    // True if any indexed frame of the active satellite has this content hash,
+    // i.e. the payload is already on flash under another timestamp. Frames
+    // not yet verified since boot, and a hash of 0, never match.
+    bool hasFrameWithHash(uint32_t hash);
+
+    // Number of indexed frames of the active satellite and their total size.
+    // Reads the index only, so it is cheap enough for every metrics scrape.
+    void indexStats(int& frames, size_t& bytes);
+
+    // Content hash recorded for <timestamp>, or 0 if the frame is not indexed
+    // (e.g. written by older firmware).
+    uint32_t frameHash(const char* timestamp);
+
+    // Quality tier of the frame for <timestamp> (including one still waiting
+    // in the write queue), or -1 if it is not cached.
+    int frameTier(const char* timestamp);
 
-    // Load the cached JPEG for <timestamp> into imageBuffer / imageSize.
-    // Returns false if the file is not found or is corrupt (zero-length).
-    bool loadImage(const String& timestamp);
+    // Delete indexed frames whose slot is no longer in the window: older than
+    // its start, or in a gap of a sparse zone (a full-cadence frame that has
+    // aged past WINDOW_FULL_HOURS and is not on a sparse slot). Called by the
+    // sync task once per pass. Returns the number of files removed.
+    int pruneOutsideWindow(const Timeline& timeline);
+
+    // Write the frame index to LittleFS if it changed since the last save.
+    // Called once per sync pass rather than per frame to limit flash wear.
+    void saveIndex();
 
     // Evict the oldest cached frame (across ALL satellite subdirectories) to free
-    // space for one incoming image. Global scope ensures stale files from a
-    // previously active satellite never block eviction for the current one.
-    void cleanup();
+    // space for one incoming image of bytesNeeded. Global scope ensures stale files
+    // from a previously active satellite never block eviction for the current one.
+    // Runs on the writer task.
+    void cleanup(size_t bytesNeeded);
 
-    // Print a cache health summary to Serial: frame count, average frame size,
-    // LittleFS used/free, and a suggestion if quality could be raised or lowered.
-    // Call this after showLastXHours() to give feedback on how full the cache is.
+    // Print a cache health summary to Serial: frame count, average frame size
+    // (per format once frames are transcoded), LittleFS used/free, and a
+    // suggestion if quality could be raised or lowered.
+    // Called by the sync task after every pass to give feedback on how full the cache is.
     void printStats();
 
 private:
-    // Metadata entry for the in-memory ring buffer.
+    // Metadata entry for the frame index ring buffer.
     struct CacheEntry {
-        String timestamp;
-        bool   valid;
+        char     timestamp[16];
+        uint32_t size;      // Expected file length in bytes
+        uint32_t hash;      // contentHash() of the stored JPEG; 0 = not yet known
+        bool     valid;
+        bool     verified;  // CRC checked since boot; later loads only check length
+        bool     rle;       // Stored as <timestamp>.rle instead of .jpg
+        uint8_t  tier;      // Quality tier: 0 = JPEG_QUALITY, 1 = CACHE_AGED_QUALITY
+    };
+
+    // A completed download waiting for the writer task. The job owns data.
+    struct WriteJob {
+        char     timestamp[16];
+        uint8_t *data;
+        size_t   size;
+        uint32_t hash;
+        bool     rle;       // data is an RLE frame replacing the .jpg
+        uint8_t  tier;
     };
 
-    CacheEntry entries[CACHE_SIZE];  // Ring buffer of recently cached timestamps
+    CacheEntry entries[CACHE_SIZE];  // Ring buffer of recently cached frames
     int        writeIndex = 0;       // Next write position in the ring buffer
+    bool       indexDirty = false;   // entries[] changed since the last saveIndex()
+
+    // Jobs queued, being written, or waiting in cacheImage() for queue space.
+    // loadImage() and hasFrameWithHash() consult these so a frame is visible
+    // the moment cacheImage() returns.
+    WriteJob  *pending[CACHE_WRITE_QUEUE_DEPTH + 2] = {};
+
+    QueueHandle_t     writeQueue = nullptr;  // WriteJob* handed to the writer task
+    SemaphoreHandle_t lock       = nullptr;  // Guards entries[] and pending[]
+    bool              started    = false;    // begin() succeeded
+
+    // Writer task entry point; drains writeQueue forever.
+    static void writerTask(void *arg);
+
+    // Synchronously write one frame to flash and index it. Evicts first if the
+    // filesystem is nearly full. Used by the writer task, and directly by
+    // cacheImage() when no RAM is left for a queued copy. An RLE frame removes
+    // the .jpg it replaces once the .rle is in place.
+    bool writeFrame(const char* timestamp, const uint8_t *data, size_t size, uint32_t hash,
+                    bool rle, uint8_t tier);
+
+    // Delete a frame that failed verification and drop its index entry.
+    void discardFrame(const char* timestamp, const char* path, const char* reason);
+
+    // Boot-time integrity pass over the active satellite's directory. Uses the
+    // directory listing and the index only: leftover .tmp files are removed,
+    // indexed frames whose length or format differs are deleted, and unindexed
+    // frames are opened just far enough to check SOI/EOI (or the RLE header)
+    // before being adopted.
+    void verifyCache();
 
-    // Returns the full LittleFS path for a given timestamp, e.g. /cache/20261081300.jpg.
-    // Creates the /cache/ directory if it does not yet exist.
-    String getCachePath(const String& timestamp);
+    // Longest cache path, e.g. "/cache/MeteosatIODC/20261021-1200.jpg", plus slack.
+    static const size_t PATH_LEN = 48;
+
+    // Write the full LittleFS path for a given timestamp into out, e.g.
+    // /cache/GOES_EAST/20261081300.jpg (or .rle). No heap, no flash access.
+    void getCachePath(const char* timestamp, bool rle, char *out, size_t len);
+
+    // Path a frame is written under before the rename, e.g. .../<ts>.tmp.
+    void getTempPath(const char* timestamp, char *out, size_t len);
+
+    // Point the index at a frame now complete at its final path, and remove
+    // the copy in the other format if the previous entry had one.
+    void indexFrame(const char* timestamp, size_t size, uint32_t hash, bool rle, uint8_t tier);
+
+    // Index slot for a new frame: the next free entry, or the oldest written.
+    // Caller holds lock (or runs before the writer task exists).
+    int allocEntry();
+
+    // Return the index of <timestamp> in entries[], or -1 if not indexed.
+    int findEntry(const char* timestamp);
+
+    // Drop the index entry for a frame file that was deleted, given its
+    // filename (e.g. "20261081300.jpg").
+    void forgetFile(const char* filename);
+
+    // Load entries[] from /meta/<satellite>.idx. A missing or mismatched file
+    // leaves the index empty; frames on flash remain loadable, just unhashed.
+    void loadIndex();
 
     // Delete all cached frames that belong to a satellite other than the active
     // SATTYPE. Called once at boot so that switching SATTYPE doesn't leave the
     // filesystem full of frames from the previous source, blocking new downloads.
     void purgeStaleSatelliteCache();
+
+    // Delete every regular file in <dirPath> whose name starts with <prefix>
+    // (nullptr = all) in batches. Returns the number of files removed.
+    static int removeFiles(const char *dirPath, const char *prefix);
 };
 
 // Global cache instance, defined in ImageCache.cpp.
@@ -1,4 +1,6 @@
-// ImageDownloader.h — satellite image retrieval and 24-hour animation playback.
+// ImageDownloader.h — satellite image retrieval and background cache sync.
+// Downloads run on their own FreeRTOS task so HTTP latency never stalls the
+// playback engine; finished frames reach playback through the cache only.
 
 #ifndef IMAGE_DOWNLOADER_H
 #define IMAGE_DOWNLOADER_H
@@ -8,44 +10,116 @@
 #include <HTTPClient.h>
 #include "ImageCache.h"
 
-// Shared image buffer, defined in main.cpp.
-// Both downloadImage() (HTTP) and loadImage() (LittleFS) write their result here
-// so the caller always draws from the same location regardless of source.
-extern uint8_t *imageBuffer;
-extern size_t   imageSize;
+class Timeline;
 
 class ImageDownloader {
 public:
-    // Fetch the satellite image for the given timestamp.
-    // Checks the LittleFS cache first; only downloads from the network on a miss.
-    // On success, imageBuffer and imageSize hold the complete JPEG.
-    // Returns true if the image is ready to be decoded and drawn.
-    static bool   downloadImage(const String& timestamp);
-
-    // Return the timestamp string for the most recently available satellite image.
-    // Subtracts SERVER_LAG_MINUTES to account for satellite processing delay, then
-    // rounds down to the nearest update cadence (10 min GOES, 30 min ElektroL, 15 min Meteosat).
-    static String getFormattedTime();
-
-    // Play back 24 hours of satellite imagery as a frame-by-frame animation.
-    // Starting from (now − SERVER_LAG_MINUTES − 24 h), iterates forward through
-    // NROFIMAGESTOSHOW evenly-spaced timestamps, downloading and immediately
-    // drawing each frame. Cache hits make this fast; misses trigger HTTP downloads.
-    // For Meteosat, cache misses are skipped silently — no download is attempted
-    // since the URL is always "latest" and fetching would corrupt historical slots.
-    static void   showLastXHours();
+    // Make sure the satellite image for the given timestamp is cached.
+    // Checks the cache index first; only downloads from the network on a miss.
+    // Returns true if the frame is cached (or queued for the cache). Returns
+    // false for a 304 or a payload identical to a frame already cached, so the
+    // same picture is never stored or shown twice.
+    // Called from the sync task only — it owns the download buffer.
+    static bool downloadImage(const char* timestamp);
+
+    // Start the background sync task: every UPDATE_INTERVAL_MS it reconnects
+    // WiFi if needed, fetches the newest slot, backfills the rest of the
+    // window coarse to fine (except Meteosat, whose URL is always "latest"),
+    // and demotes aged frames to the lower-quality tier when flash is filling
+    // up.
+    // Call once from setup() after cache.begin() and missCache.begin().
+    static void startSync();
 
 private:
-    // Build the complete ImageKit URL for the given timestamp and active SATTYPE.
-    // Embeds DISPLAY_WIDTH, DISPLAY_HEIGHT, and JPEG_QUALITY as resize parameters.
-    static String constructUrl(const String& timestamp);
-
-    // Convert a tm struct to the satellite-source-specific timestamp string.
-    // GOES:     YYYYDDDHHMM   (day-of-year, minutes rounded to nearest 10)
-    // ElektroL: YYYYMMDD-HHMM (minutes rounded to nearest 30)
-    // Meteosat: YYYYMMDD-HHMM (minutes rounded to nearest 15) — cache key only,
-    //           not embedded in the URL (which is always the static latest image)
-    static String formatTimestamp(const struct tm& t);
+    // Write the complete ImageKit URL for the given timestamp and active SATTYPE
+    // into out. Embeds DISPLAY_WIDTH, DISPLAY_HEIGHT, and the tier's quality
+    // (JPEG_QUALITY for tier 0, CACHE_AGED_QUALITY for tier 1) as resize
+    // parameters. Returns false if the URL does not fit in len bytes.
+    static bool constructUrl(const char* timestamp, uint8_t tier, char *out, size_t len);
+
+    // Download the frame for <timestamp> at the given tier's quality into
+    // downloadBuffer / downloadSize. Returns HTTP_CODE_OK on a complete body,
+    // otherwise the HTTP status or an HTTPC_ERROR_* code
+    // (HTTPC_ERROR_TOO_LESS_RAM when no buffer or URL could be made).
+    // A stalled body is resumed with HTTP Range requests, at once and on later
+    // passes (see loadPartial()). Records download metrics but leaves
+    // missCache to the caller.
+    static int fetchFrame(const char* timestamp, uint8_t tier);
+
+    // Ask the LAN peers (see PeerCache.h) for the frame at the given tier,
+    // into downloadBuffer / downloadSize. Returns true on a body that matches
+    // the sender's content hash; false sends the caller on to fetchFrame().
+    static bool fetchFromPeer(const char* timestamp, uint8_t tier);
+
+    // Hand the full-quality frame in downloadBuffer to the cache and record
+    // the success in missCache. Returns false, storing nothing, if the payload
+    // matches a frame already cached.
+    static bool storeDownload(const char* timestamp);
+
+    // One GET of <url>. If <have> > 0, downloadBuffer holds that many leading
+    // bytes and only the rest is requested (Range + If-Range). On return
+    // <have> is how much of the frame downloadBuffer holds for a resume, or 0.
+    // Returns HTTP_CODE_RANGE_NOT_SATISFIABLE if the server rejected the range.
+    static int transfer(const char* url, size_t &have);
+
+    // Fetch the newest slot while drawing it, teeing the bytes to the cache
+    // file (STREAM_LATEST_FRAME), unless a LAN peer already has it. Returns
+    // false, having done nothing, when the slot should go through
+    // downloadImage() instead.
+    static bool streamLatest(const char* timestamp);
+
+    // True when the active source is a static "latest" image (Meteosat/IODC),
+    // where conditional GET applies.
+    static bool isLatestOnlySource();
+
+    // Sync task entry point and one pass over the window.
+    static void syncTask(void *arg);
+    static void syncOnce(Timeline& timeline);
+
+    // Try to re-fetch up to CACHE_AGED_PER_PASS aged frames at
+    // CACHE_AGED_QUALITY while LittleFS is above CACHE_AGED_FILL_THRESHOLD;
+    // stops at the first network error.
+    static void demoteAgedFrames(Timeline& timeline);
+
+    // Download target, grown on demand and reused across frames.
+    static uint8_t *downloadBuffer;
+    static size_t   downloadCapacity;
+    static size_t   downloadSize;      // Length of the last fetchFrame() body
+
+    // Make downloadBuffer at least <bytes> long. Returns false if out of memory.
+    static bool reserveDownloadBuffer(size_t bytes);
+
+    // Resume state for the frame in downloadBuffer: its full length and the
+    // ETag or Last-Modified sent back as If-Range.
+    static size_t resumeTotal;
+    static char   resumeValidator[80];
+
+    // The stalled body saved in /meta/<satellite>.part, if any. Only one is
+    // kept; a newer stall replaces it.
+    static char    partialTimestamp[16];  // "" = none
+    static uint8_t partialTier;
+    static bool    partialChecked;        // File header read since boot
+
+    // If the saved partial is for <timestamp> at <tier>, load it into
+    // downloadBuffer and the resume state and return its length; otherwise 0.
+    static size_t loadPartial(const char* timestamp, uint8_t tier);
+
+    // Save the first <have> bytes of downloadBuffer for a later resume.
+    static void savePartial(const char* timestamp, uint8_t tier, size_t have);
+
+    // Delete the saved partial.
+    static void dropPartial();
+
+    // HTTP validators from the last successful "latest" download, sent back as
+    // If-None-Match / If-Modified-Since so an unchanged image costs a 304
+    // instead of a full transfer. Persisted in /meta/<satellite>.http.
+    static String etag;
+    static String lastModified;
+    static bool   validatorsLoaded;
+
+    // Read / write the persisted validators (one per line: ETag, Last-Modified).
+    static void loadValidators();
+    static void saveValidators(const String& newEtag, const String& newLastModified);
 };
 
 #endif
@@ -0,0 +1,61 @@
+// JpegDecoder.h — pluggable JPEG decoder backends.
+// Every backend decodes a JPEG held in RAM and delivers RGB565 blocks through
+// the same tft_output() callback (Display.h), so the display, the RLE tee and
+// the blit timing work unchanged whichever decoder is active.
+//
+// Backends:
+//   TJpgDec  — bodmer/TJpg_Decoder, portable scalar code (default)
+//   JPEGDEC  — bitbank2/JPEGDEC; on ESP32-S3 it uses the S3 SIMD instructions
+//              for IDCT and colour conversion. Compiled in, and made the active
+//              backend, by the JPEG_DECODER_JPEGDEC build flag (see platformio.ini).
+//              If its ~18 KB of internal RAM is not available at begin(),
+//              jpegDecoder falls back to TJpgDec.
+
+#ifndef JPEG_DECODER_H
+#define JPEG_DECODER_H
+
+#include <Arduino.h>
+
+class JpegDecoder {
+public:
+    virtual ~JpegDecoder() {}
+
+    // Short name for logs and the decoder bench.
+    virtual const char *name() const = 0;
+
+    // Wire the backend to tft_output() and allocate its state. Call once
+    // before the first draw(). Returns false if no memory.
+    virtual bool begin() = 0;
+
+    // Image dimensions from the JPEG header. Returns false if not a JPEG.
+    virtual bool getSize(const uint8_t *data, size_t size, uint16_t *w, uint16_t *h) = 0;
+
+    // Decode the JPEG with its top-left corner at (x, y), handing each block
+    // to tft_output(). Returns false if the JPEG is malformed.
+    virtual bool draw(int16_t x, int16_t y, const uint8_t *data, size_t size) = 0;
+
+    // Bytes the backend holds permanently (decoder object and work buffers),
+    // as opposed to what it allocates per frame.
+    virtual size_t stateBytes() const = 0;
+};
+
+// Active backend, defined in JpegDecoder.cpp.
+extern JpegDecoder &jpegDecoder;
+
+// The i-th compiled-in backend, or nullptr past the last. Used by the decoder
+// bench to compare every backend on the same frames.
+JpegDecoder *jpegBackend(int i);
+
+// Pull-style input for drawJpegStream(): copy up to <len> bytes into <buf>,
+// or skip them if buf is nullptr. Return the number of bytes delivered;
+// fewer than asked (e.g. 0 on a stalled socket) makes the decode fail.
+typedef size_t (*JpegReadFn)(void *ctx, uint8_t *buf, size_t len);
+
+// Decode a JPEG as its bytes arrive, drawing each MCU row through
+// tft_output() as soon as it is complete. Always uses tjpgd (the core of
+// TJpgDec), whose input is a read callback; JPEGDEC needs the whole file up
+// front. Holds a ~3 KB work area, not the frame. Returns false if the JPEG
+// is malformed or the input ran dry. Call with the display locked.
+bool drawJpegStream(int16_t x, int16_t y, JpegReadFn read, void *ctx);
+
+#endif
@@ -0,0 +1,167 @@
+// Metrics.h — runtime counters and the on-device HTTP metrics endpoint.
+// Modules record events here (downloads, evictions, frame timings); a small
+// WebServer on its own FreeRTOS task serves them as JSON (/status) and as
+// Prometheus text exposition (/metrics), so a wall-mounted unit can be
+// monitored without USB Serial.
+// Recording is a handful of 32-bit stores — no locks — so it is safe to call
+// from the playback loop, the sync task and the cache writer alike. Serving
+// a scrape reads the same words from the server task and never touches the
+// display or flash, so a scrape cannot stall a frame. The same server also
+// answers /frame for LAN peers (see PeerCache.h), which reads LittleFS but
+// not the display.
+
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <Arduino.h>
+#include "config.h"
+
+class Metrics {
+public:
+    // Start the HTTP server task on METRICS_PORT. Safe to call more than once
+    // (e.g. after every WiFi reconnect); only the first call starts the task.
+    void startServer();
+
+    // A frame was downloaded: <bytes> of body, <latencyMs> until the response
+    // headers arrived, <transferMs> to read the body.
+    void recordDownload(size_t bytes, uint32_t latencyMs, uint32_t transferMs);
+
+    // A download attempt failed (non-200, short read, or no memory).
+    void recordDownloadFailure();
+
+    // A stalled download was retried with a Range request.
+    void recordDownloadRetry();
+
+    // <bytes> already received were thrown away: a partial body that could
+    // not be resumed, or one the server would not resume from.
+    void recordDownloadWaste(size_t bytes);
+
+    // A resumed download completed; <bytes> did not have to be fetched again.
+    void recordDownloadResumed(size_t bytes);
+
+    // The writer task stored a frame of <bytes> on flash.
+    void recordCacheWrite(size_t bytes);
+
+    // cleanup() evicted a frame to make room.
+    void recordEviction();
+
+    // A frame was replaced by its smaller aged-tier copy, freeing <bytesSaved>.
+    void recordDemotion(size_t bytesSaved);
+
+    // The playback engine drew a frame: time spent decoding (JPEG decode or
+    // RLE expansion) and time spent pushing pixels to the panel, both in
+    // microseconds, plus the stored format and size of the frame and the
+    // number of blocks it was blitted in.
+    void recordFrame(uint32_t decodeUs, uint32_t blitUs, bool rle, size_t bytes, uint32_t tiles);
+
+    // A frame could not be drawn (malformed JPEG or RLE stream). Its timings
+    // are left out of the frame figures above.
+    void recordFrameFailure();
+
+    // The newest frame was drawn while it downloaded: <firstPixelMs> from the
+    // request to the first decoded block, <totalMs> to the last byte.
+    void recordLiveFrame(uint32_t firstPixelMs, uint32_t totalMs);
+
+    // Playback wanted a frame: <hit> if the prefetch ring already held it.
+    void recordPrefetch(bool hit);
+
+    // The prefetch ring was resized to <depth> frames.
+    void setPrefetchDepth(int depth);
+
+    // A LAN peer was asked for a frame: <hit> if one of <bytes> arrived
+    // intact, a miss for a 404 or a bad body.
+    void recordPeerFetch(bool hit, size_t bytes);
+
+    // A frame of <bytes> was served to a LAN peer.
+    void recordPeerServed(size_t bytes);
+
+    // Peer discovery found <count> matching units.
+    void setPeerCount(int count);
+
+    // Close the current boot phase: record <name> with the time since the
+    // previous call (or since reset, for the first). Called from setup() and
+    // the modules it initialises; phases past METRICS_BOOT_PHASES are dropped.
+    void bootPhase(const char *name);
+
+    // Print the recorded boot phases and their total to Serial.
+    void printBootReport();
+
+    // Render the current counters into buf. Return the length written.
+    size_t renderJson(char *buf, size_t len);
+    size_t renderPrometheus(char *buf, size_t len);
+
+private:
+    // Downloads
+    uint32_t downloads        = 0;
+    uint32_t downloadFailures = 0;
+    uint32_t downloadBytes    = 0;  // Wraps at 4 GB; Prometheus rate() copes
+    uint32_t downloadMsTotal  = 0;  // Sum of latency + transfer, for the average
+    uint32_t lastLatencyMs    = 0;
+    uint32_t lastThroughputBps = 0;
+    uint32_t downloadRetries  = 0;
+    uint32_t wastedBytes      = 0;
+    uint32_t resumedBytes     = 0;
+
+    // Cache
+    uint32_t cacheWrites      = 0;
+    uint32_t cacheWriteBytes  = 0;
+    uint32_t evictions        = 0;
+    uint32_t demotions        = 0;
+    uint32_t demotionBytesSaved = 0;
+
+    // Playback
+    uint32_t framesDrawn      = 0;
+    uint32_t frameFailures    = 0;
+    uint32_t lastDecodeUs     = 0;
+    uint32_t lastBlitUs       = 0;
+    uint32_t decodeUsTotal    = 0;
+    uint32_t blitUsTotal      = 0;
+    uint32_t lastFrameAt      = 0;  // millis() of the previous frame
+    float    fps              = 0;  // Smoothed over recent frames while playing
+
+    // Per stored format (0 = JPEG, 1 = RLE), to compare the two paths.
+    struct FormatStats {
+        uint32_t frames   = 0;
+        uint32_t decodeUs = 0;
+        uint32_t blitUs   = 0;
+        uint32_t bytes    = 0;
+        uint32_t tiles    = 0;
+    };
+    FormatStats formats[2];
+
+    // Live (streamed) frames
+    uint32_t liveFrames       = 0;
+    uint32_t lastFirstPixelMs = 0;
+    uint32_t lastLiveTotalMs  = 0;
+
+    // Read-ahead
+    uint32_t prefetchHits     = 0;
+    uint32_t prefetchMisses   = 0;
+    int      prefetchDepth    = 0;
+
+    // LAN peers
+    uint32_t peerHits         = 0;
+    uint32_t peerMisses       = 0;
+    uint32_t peerBytes        = 0;
+    uint32_t peerServed       = 0;
+    uint32_t peerServedBytes  = 0;
+    int      peerCount        = 0;
+
+    // Boot phases, in the order they ran. Names must be string literals.
+    struct BootPhase {
+        const char *name;
+        uint32_t    ms;
+    };
+    BootPhase bootPhases[METRICS_BOOT_PHASES];
+    int       bootPhaseCount = 0;
+    uint32_t  bootMarkMs     = 0;  // millis() at the end of the previous phase
+
+    bool     serverStarted    = false;
+
+    static void serverTask(void *arg);
+};
+
+// Global metrics instance, defined in Metrics.cpp.
+extern Metrics metrics;
+
+#endif
@@ -0,0 +1,73 @@
+// MissCache.h — negative cache for satellite slots that failed to download.
+// When NOAA skips a slot or ImageKit answers 404, retrying the same timestamp
+// on every animation pass wastes a round trip (and up to DOWNLOAD_TIMEOUT_MS)
+// per missing frame. This table remembers failed slots together with the time
+// at which they may next be retried, using a backoff schedule that depends on
+// the HTTP status: "not found" backs off slowly and eventually gives up, while
+// transient failures (timeouts, 5xx) are retried quickly.
+// The table is persisted to /meta/<satellite>.miss so backoff survives reboots.
+
+#ifndef MISS_CACHE_H
+#define MISS_CACHE_H
+
+#include <Arduino.h>
+#include "config.h"
+
+class MissCache {
+public:
+    // Load the persisted table for the active satellite. Must be called after
+    // LittleFS is mounted (i.e. after cache.begin()) and after NTP sync, since
+    // retry times are stored as UTC epoch seconds.
+    void begin();
+
+    // True while <timestamp> is still inside its backoff window and should not
+    // be fetched from the network.
+    bool shouldSkip(const char* timestamp);
+
+    // Record a failed download. httpCode is the HTTP status, or a negative
+    // HTTPC_ERROR_* value for connection-level failures. Each consecutive
+    // failure doubles the backoff for that slot.
+    void recordFailure(const char* timestamp, int httpCode);
+
+    // True if <timestamp> has failed before and not succeeded since, even if
+    // its backoff has expired.
+    bool hasFailed(const char* timestamp) const { return find(timestamp) >= 0; }
+
+    // Forget <timestamp> after a successful download.
+    void recordSuccess(const char* timestamp);
+
+    // Drop entries older than <oldestTimestamp> — slots that have scrolled out
+    // of the animation window will never be requested again.
+    void prune(const char* oldestTimestamp);
+
+    // Write the table to LittleFS if it changed since the last save.
+    // Called once per animation pass rather than per failure to limit flash wear.
+    void save();
+
+private:
+    struct MissEntry {
+        char     timestamp[16];  // Slot key, same format as the cache filename
+        int16_t  httpCode;       // Last failure status (negative = HTTPC_ERROR_*)
+        uint8_t  failures;       // Consecutive failures for this slot
+        uint32_t retryAt;        // UTC epoch seconds; UINT32_MAX = gave up
+    };
+
+    MissEntry entries[MISS_CACHE_SIZE];
+    int       count = 0;
+    bool      dirty = false;
+
+    // Return the index of <timestamp> in entries[], or -1 if not present.
+    int find(const char* timestamp) const;
+
+    // Seconds to wait before the next attempt, given the failure status and
+    // how many times in a row this slot has failed.
+    static uint32_t backoffSeconds(int httpCode, uint8_t failures);
+
+    // Path of the persisted table, e.g. /meta/GOES_EAST.miss.
+    static String tablePath();
+};
+
+// Global negative cache instance, defined in MissCache.cpp.
+extern MissCache missCache;
+
+#endif
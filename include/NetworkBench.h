@@ -0,0 +1,18 @@
+// NetworkBench.h — on-device download soak/benchmark (bench_network env only).
+// Drives ImageDownloader against the local stand-in server in
+// tools/imagekit_stub.py (BENCH_ENDPOINT) from an empty cache and reports how
+// long the backfill takes, how downloads time out, and what retries cost.
+
+#ifndef NETWORK_BENCH_H
+#define NETWORK_BENCH_H
+
+#ifdef NETWORK_BENCH
+
+// Format LittleFS, start the cache, run backfill passes until the window is
+// complete or BENCH_MAX_PASSES is reached, and print a report to Serial.
+// Call from setup() in place of cache.begin(); does not return.
+void runNetworkBench();
+
+#endif
+
+#endif
@@ -0,0 +1,61 @@
+// PeerCache.h — share cached frames with other FlatEarth units on the LAN.
+// Every unit advertises itself over mDNS as _flatearth._tcp (instance name
+// DEVICENAME) with its satellite and display size in TXT records, and serves
+// its cached JPEGs at /frame on the metrics HTTP server. Before asking
+// ImageKit for a frame, the sync task asks the matching peers; a fleet then
+// pulls each frame from the origin roughly once and backfills over the LAN.
+//
+//   GET /frame?sat=<SATTYPE_NAME>&ts=<timestamp>&w=<width>&h=<height>&q=<quality>
+//     200 + the JPEG if this unit holds that frame at that size and quality,
+//     404 otherwise (including pre-decoded .rle frames, which are
+//     display-native rather than JPEG).
+
+#ifndef PEER_CACHE_H
+#define PEER_CACHE_H
+
+#include <Arduino.h>
+#include <IPAddress.h>
+#include "config.h"
+
+class WebServer;
+
+class PeerCache {
+public:
+    // Start mDNS and advertise this unit. Call after WiFi connects; safe to
+    // call again after a reconnect (only the first call does anything).
+    void begin();
+
+    // Re-run peer discovery if PEER_REFRESH_MS has passed since the last
+    // query. Blocks for the mDNS query (up to a few seconds), so call from
+    // the sync task only.
+    void refresh();
+
+    // Peers found by the last refresh() that are still considered healthy.
+    int count() const { return peerCount; }
+    const IPAddress& address(int i) const { return peers[i].address; }
+    uint16_t         port(int i)    const { return peers[i].port; }
+
+    // Stop asking peer <i> until the next discovery, e.g. after it failed to
+    // connect.
+    void drop(int i);
+
+    // /frame handler, registered on the metrics server.
+    static void serve(WebServer& server);
+
+private:
+    struct Peer {
+        IPAddress address;
+        uint16_t  port;
+    };
+
+    Peer          peers[PEER_MAX];
+    int           peerCount   = 0;
+    bool          started     = false;
+    unsigned long refreshedAt = 0;
+    bool          refreshed   = false;  // At least one query has run
+};
+
+// Global peer cache, defined in PeerCache.cpp.
+extern PeerCache peerCache;
+
+#endif
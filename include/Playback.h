@@ -0,0 +1,135 @@
+// Playback.h — touch-driven animation engine for the cached satellite window.
+// Playback only ever reads from the cache; downloading happens on the
+// background sync task (see ImageDownloader::startSync()), so touch input is
+// handled within one tick even while a sync is running.
+//
+// Gestures (Waveshare touch board):
+//   tap          — play / pause
+//   drag sideways — scrub: finger position across the screen maps to the
+//                   window, oldest at the left edge, newest at the right
+//   swipe up/down — faster / slower
+//   long press   — toggle ping-pong (bounce at the ends instead of wrapping)
+// Boards without touch run the same engine unattended: forward loop, pausing
+// PLAYBACK_HOLD_MS on the newest frame.
+//
+// The playhead steps through every slot of the window, cached or not, and
+// shows the nearest cached frame, holding it across the gaps. A cache that is
+// still backfilling (coarse to fine, see Timeline::backfillOrder()) therefore
+// already plays the whole window at its real pace, just with fewer distinct
+// frames.
+
+#ifndef PLAYBACK_H
+#define PLAYBACK_H
+
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include "Timeline.h"
+#include "Touch.h"
+
+class Playback {
+public:
+    // Initialise touch input, build the window, and show the newest cached
+    // frame straight away. Call once from setup() after cache.begin().
+    void begin();
+
+    // Poll touch, handle gestures, and draw the next frame when it is due.
+    // Touch is polled during a live frame too; a scrub made meanwhile is
+    // drawn once the live frame ends. Never blocks longer than one frame
+    // decode; call from loop() continuously.
+    void tick();
+
+    // Live frame hand-off with the sync task, which may draw the newest frame
+    // while it downloads (ImageDownloader::streamLatest()). beginLiveFrame()
+    // returns false while the user is paused or scrubbing; otherwise playback
+    // leaves the display alone until endLiveFrame(). <complete> means the whole
+    // frame is on screen: playback then holds on it as the newest frame.
+    // Otherwise the next cached frame is drawn over the partial one at once.
+    bool beginLiveFrame();
+    void endLiveFrame(const char* timestamp, uint32_t hash, bool complete);
+
+private:
+    Timeline      timeline;
+    int           shownSlot   = -1;     // Slot on screen (-1 = nothing drawn yet)
+    char          shownTimestamp[16] = "";  // Survives window shifts; shownSlot does not
+    int           playSlot    = -1;     // Playhead; may be an uncached slot held by shownSlot
+    char          playTimestamp[16]  = "";
+    uint32_t      shownHash   = 0;      // Content hash of the frame on screen
+    int8_t        direction   = 1;      // +1 forward in time, -1 backward (ping-pong)
+    bool          paused      = false;  // Written under liveLock; see setHold()
+    bool          scrubbing   = false;  // Written under liveLock; see setHold()
+    bool          pingPong    = PLAYBACK_PINGPONG;
+    uint8_t       speedIndex  = PLAYBACK_DEFAULT_SPEED;
+    unsigned long nextFrameAt = 0;      // millis() when the next frame is due
+    uint8_t       cachedBits[(NROFIMAGESTOSHOW + 7) / 8];  // Cached slots, see isCached()
+    bool          cachedValid = false;  // cachedBits taken during this tick
+
+    // Live frame state, written by the sync task and consumed in tick(),
+    // both under liveLock.
+    SemaphoreHandle_t liveLock = nullptr;
+    bool          live         = false;  // Sync task owns the display
+    bool          liveEnded    = false;  // endLiveFrame() not yet handled
+    bool          liveComplete = false;
+    char          liveTimestamp[16] = "";
+    uint32_t      liveHash     = 0;
+    int           deferredSeek = -1;     // Scrub target held while a live frame draws
+
+    // Act on a gesture. With <deferDraw> set the sync task owns the display,
+    // so a scrub only records its target in deferredSeek.
+    void handleTouch(const TouchEvent& ev, bool deferDraw);
+
+    // Set paused and scrubbing under liveLock, so beginLiveFrame() on the
+    // sync task never grants the display against a hold the user just made.
+    // The loop task is their only writer and may read them without the lock.
+    void setHold(bool pause, bool scrub);
+
+    // True while the sync task owns the display; reads live under liveLock.
+    bool liveFrameActive();
+
+    // Move the playhead one slot in the current direction, wrapping or
+    // bouncing at the ends of the window, and draw the nearest cached frame
+    // unless it is already on screen.
+    void advance();
+
+    // Put the playhead on <slot>.
+    void setPlayhead(int slot);
+
+    // The cached slot whose frame advance() shows next after the one at
+    // <from>, updating <dir> on a bounce or wrap. -1 if nothing is cached.
+    int  followingSlot(int from, int8_t& dir);
+
+    // Ask the prefetcher for the frames advance() will show next.
+    void planPrefetch();
+
+    // Move the playhead to <slot> and draw the nearest cached frame
+    // immediately.
+    void seek(int slot);
+
+    // True if <slot> is cached. Reads a snapshot of the whole window taken
+    // with one cache lock on the first call of each tick.
+    bool isCached(int slot);
+
+    // First cached slot at or after <from> walking in <dir>, or -1.
+    int  nextCachedSlot(int from, int dir);
+
+    // Cached slot closest to <slot> in either direction, or -1.
+    int  nearestCachedSlot(int slot);
+
+    // Load and decode the frame for <slot>. Unless force is set, a frame with
+    // the same content hash as the one on screen is skipped without decoding.
+    // Returns true if pixels were drawn.
+    bool drawSlot(int slot, bool force);
+
+    // Delay between frames at the current speed.
+    uint32_t frameDelay() const;
+
+#ifdef ALLOC_AUDIT
+    // Periodic heap-allocation report for the alloc_audit build.
+    void reportAllocations();
+#endif
+};
+
+// Global playback engine, defined in Playback.cpp.
+extern Playback player;
+
+#endif
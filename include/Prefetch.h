@@ -0,0 +1,76 @@
+// Prefetch.h — read-ahead of upcoming cached frames into a RAM ring.
+// After each frame the playback engine lists the next frames it will show;
+// a background task loads them from LittleFS into a ring of buffers (PSRAM
+// where present) while the current frame decodes. When a frame is due,
+// playback takes it straight from the ring, so a warm loop no longer waits
+// on a flash open and read before every decode.
+//
+// Ring slots stay filled after use: a frame that is still wanted (a short
+// window, or ping-pong) is not read again. A slot is reused only for a frame
+// no longer on the wanted list. The ring depth follows free memory (see
+// PREFETCH_* in config.h) and is reported with the hit rate in /status.
+
+#ifndef PREFETCH_H
+#define PREFETCH_H
+
+#include <Arduino.h>
+#include "config.h"
+#include "ImageCache.h"
+
+class Prefetcher {
+public:
+    // Start the prefetch task. Call once from setup() after cache.begin().
+    // Does nothing when PREFETCH_MAX_DEPTH is 0.
+    void begin();
+
+    // Frames the ring may hold right now, from free memory and the average
+    // cached frame size. Playback plans this many frames ahead.
+    int depth() const { return targetDepth; }
+
+    // Replace the wanted list with <count> timestamps in playback order and
+    // wake the task. Timestamps are copied. Called from the loop task.
+    void request(const char *const *timestamps, int count);
+
+    // If <timestamp> is loaded, pin its slot and return the frame; the data
+    // stays valid until release(). Records a hit or a miss either way.
+    bool take(const char *timestamp, const uint8_t **data, size_t *size);
+
+    // Unpin the slot returned by the last take().
+    void release();
+
+    // Drop the ring copy of <timestamp>, e.g. once the cache holds a newer
+    // format of the frame.
+    void forget(const char *timestamp);
+
+private:
+    enum class SlotState : uint8_t { Empty, Loading, Ready, InUse };
+
+    struct Slot {
+        char        timestamp[16];
+        FrameBuffer buf;
+        SlotState   state;
+    };
+
+    Slot              slots[PREFETCH_MAX_DEPTH > 0 ? PREFETCH_MAX_DEPTH : 1] = {};
+    char              wanted[PREFETCH_MAX_DEPTH > 0 ? PREFETCH_MAX_DEPTH : 1][16] = {};
+    int               wantedCount = 0;
+    volatile int      targetDepth = 0;
+    SemaphoreHandle_t lock        = nullptr;
+    TaskHandle_t      task        = nullptr;
+
+    static void prefetchTask(void *arg);
+
+    // Load every wanted frame that is not in the ring yet, nearest first.
+    void fill();
+
+    // Recompute targetDepth and free the buffers of unused slots beyond it.
+    void adaptDepth();
+
+    // True if <timestamp> is on the wanted list. Caller holds lock.
+    bool isWanted(const char *timestamp) const;
+};
+
+// Global prefetcher, defined in Prefetch.cpp.
+extern Prefetcher prefetcher;
+
+#endif
@@ -0,0 +1,65 @@
+// Timeline.h — the animation window as an indexed list of satellite slots.
+// Slot 0 is the oldest frame in the window, slot count()-1 the most recently
+// available one. Slots are evenly spaced at the source cadence for the newest
+// WINDOW_FULL_HOURS and sparser further back (see WINDOW_* in config.h), so
+// use ageMinutes() rather than assuming a fixed step between slots.
+// Every slot's timestamp string is precomputed on refresh(), so
+// looking up the cache key for any position is O(1) — the playback engine can
+// seek anywhere without walking the window.
+// Each task that needs the window (playback, background sync) keeps its own
+// Timeline instance, so no locking is required.
+
+#ifndef TIMELINE_H
+#define TIMELINE_H
+
+#include <Arduino.h>
+#include <time.h>
+#include "config.h"
+
+class Timeline {
+public:
+    // Rebuild the window so that it ends at the newest available slot
+    // (now − SERVER_LAG_MINUTES, snapped to the source cadence).
+    // Cheap when nothing changed. Returns true if the window moved.
+    bool refresh();
+
+    // Number of slots in the window (at most NROFIMAGESTOSHOW; 0 until time is valid).
+    int count() const { return slotCount; }
+
+    // Cache key of slot i, e.g. "20262911230" for GOES.
+    const char* timestamp(int i) const { return stamps[i]; }
+
+    // Minutes between slot i and the newest slot.
+    int ageMinutes(int i) const { return (times[slotCount - 1] - times[i]) / 60; }
+
+    // Index of the slot with this timestamp, or -1 if it is not in the window.
+    int indexOf(const char* timestamp) const;
+
+    // Write every slot but the newest into <out> in backfill order, coarse to
+    // fine: every BACKFILL_COARSE_STRIDE-th slot counting back from the
+    // newest, then those halfway between, halving the spacing down to one.
+    // Each level runs newest first. Returns the number written (count() - 1).
+    int backfillOrder(int *out) const;
+
+    // Minutes between consecutive images of the active source — the slot
+    // spacing within the newest WINDOW_FULL_HOURS.
+    static int stepMinutes();
+
+    // Format a normalised tm struct into buf as the timestamp string for the
+    // active source. 16 bytes is always enough.
+    // GOES:     YYYYDDDHHMM   (day-of-year, minutes rounded down to 10)
+    // ElektroL: YYYYMMDD-HHMM (minutes rounded down to 30)
+    // Meteosat: YYYYMMDD-HH00 — cache key only, not embedded in the URL
+    //           (which is always the static latest image)
+    static void formatTimestamp(const struct tm& t, char *buf, size_t len);
+
+private:
+    char   stamps[NROFIMAGESTOSHOW][16];  // Cache key per slot, oldest first
+    time_t times[NROFIMAGESTOSHOW];       // UTC time of each slot
+    int    slotCount = 0;
+
+    // Slot spacing (minutes) for a slot <ageSeconds> older than the newest.
+    static int spacingAt(long ageSeconds);
+};
+
+#endif
@@ -0,0 +1,37 @@
+// Touch.h — touch input and gesture recognition for the playback engine.
+// Only the Waveshare ESP32-S3-Touch-LCD-1.46B has a touch controller (SPD2010,
+// I2C). On other boards initTouch() returns false and pollTouch() never reports a
+// gesture, so the playback engine simply runs unattended.
+
+#ifndef TOUCH_H
+#define TOUCH_H
+
+#include <Arduino.h>
+
+// High-level gestures produced by pollTouch().
+enum class Gesture : uint8_t {
+    None,
+    Tap,        // short touch without movement
+    LongPress,  // touch held still for TOUCH_LONGPRESS_MS
+    SwipeUp,    // vertical flick, finger moving towards the top edge
+    SwipeDown,  // vertical flick, finger moving towards the bottom edge
+    Scrub,      // horizontal drag in progress; x holds the finger position
+    ScrubEnd,   // finger lifted after a scrub
+};
+
+struct TouchEvent {
+    Gesture gesture;
+    int16_t x;  // display coordinates of the finger (Scrub / ScrubEnd)
+    int16_t y;
+};
+
+// Initialise the touch controller. Returns false if the board has none or the
+// controller does not respond.
+bool initTouch();
+
+// Read the controller (only when its interrupt line signals new data) and
+// advance the gesture recogniser. Returns at most one event per call; cheap
+// enough to call on every playback tick.
+TouchEvent pollTouch();
+
+#endif
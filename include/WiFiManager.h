@@ -7,7 +7,22 @@
 // Tries the primary network (WIFI_SSID1) first. If it cannot connect within
 // WIFI_CONNECT_ATTEMPTS × WIFI_CONNECT_DELAY_MS milliseconds, it falls back
 // to the secondary network (WIFI_SSID2).
-// Blocks until a connection is established or both networks fail.
+// Blocks until a connection is established or both networks fail, and shows
+// progress on screen, so it is for boot only. Once connected, calls
+// startNetworkServices().
 void setupWiFi();
 
+// Reconnect after WiFi drops, for the sync task while playback owns the
+// display: draws nothing and returns at once. Each call that finds no
+// attempt in progress starts one; an attempt gets the same
+// WIFI_CONNECT_ATTEMPTS × WIFI_CONNECT_DELAY_MS as at boot before the next
+// call moves on to the other network.
+void reconnectWiFi();
+
+// Start the metrics HTTP server and the LAN peer cache once WiFi is connected
+// and the frame cache is up, since both serve from the cache. Called from
+// setupWiFi(), from setup() after cache.begin() and from each sync pass; safe
+// to call any number of times.
+void startNetworkServices();
+
 #endif
@@ -7,6 +7,13 @@
 
 #include "secrets.h"
 
+// bench_network builds send every request to the local stand-in server
+// (tools/imagekit_stub.py) instead of ImageKit.
+#ifdef BENCH_ENDPOINT
+#undef IMAGEKIT_ENDPOINT
+#define IMAGEKIT_ENDPOINT BENCH_ENDPOINT
+#endif
+
 // ── Device ──────────────────────────────────────────────────────────────────
 #define DEVICENAME "ESP-FlatEarth"  // mDNS hostname and WiFi station name
 
@@ -24,6 +31,12 @@
 #define DISPLAY_HEIGHT 240
 #endif
 #define DISPLAY_ROTATION 0  // 0 = normal  1 = 90°  2 = 180°  3 = 270°
+// Blit decoded blocks straight to the board's bus and panel classes instead of
+// through Arduino_GFX's virtual draw path (see Display.cpp). Overridable from
+// build_flags to compare the two with the decoder or render bench.
+#ifndef DISPLAY_DIRECT_BLIT
+#define DISPLAY_DIRECT_BLIT true
+#endif
 
 // ── Pin assignments — upesy_wroom / GC9A01 240×240 (standard SPI) ───────────
 #define GC9A01_INVERT_COLORS true  // Some GC9A01 panels ship with inverted colors; set false if yours looks correct
@@ -43,11 +56,82 @@
 #define WAVESHARE_D2_PIN        42
 #define WAVESHARE_D3_PIN        41
 
+// ── Touch — Waveshare ESP32-S3 / SPD2010 (I2C) ──────────────────────────────
+#define WAVESHARE_TOUCH_ADDR    0x53  // SPD2010 touch controller I2C address
+#define WAVESHARE_TOUCH_SDA_PIN   11
+#define WAVESHARE_TOUCH_SCL_PIN   10
+#define WAVESHARE_TOUCH_INT_PIN    4  // Pulled low by the controller while data is pending
+#define TOUCH_MOVE_PX             20  // Movement below this counts as "still" (tap / long press)
+#define TOUCH_LONGPRESS_MS       600  // Hold time for a long press (ms)
+#define TOUCH_RELEASE_MS          80  // No report for this long = finger lifted (ms)
+
 // ── WiFi ─────────────────────────────────────────────────────────────────────
 // Credentials (WIFI_SSID1/2, WIFI_PASSWORD1/2) are defined in secrets.h.
 #define WIFI_CONNECT_ATTEMPTS  20  // Attempts per network before trying the backup (~10 s)
 #define WIFI_CONNECT_DELAY_MS 500  // Delay between each attempt (ms)
 
+// ── Metrics endpoint ─────────────────────────────────────────────────────────
+// Served once WiFi is up: http://<device-ip>/status (JSON), /metrics (Prometheus).
+#define METRICS_PORT             80  // HTTP port for /status and /metrics
+#define METRICS_POLL_MS          20  // Server task poll interval — bounds scrape latency (ms)
+#define METRICS_FPS_GAP_MS     2000  // Frame gaps longer than this (pause, hold) are left out of FPS (ms)
+#define METRICS_BODY_SIZE      6144  // Response buffer (bytes)
+#define METRICS_TASK_STACK     6144  // Server task stack (bytes); /frame streams from LittleFS
+#define METRICS_TASK_PRIORITY     1  // Same priority as loopTask
+#define METRICS_TASK_CORE         0  // Beside WiFi; playback keeps core 1 to itself
+#define METRICS_BOOT_PHASES      12  // Boot phases timed and reported (see Metrics::bootPhase)
+
+// ── LAN peer cache ───────────────────────────────────────────────────────────
+// Units on the same LAN find each other over mDNS (_flatearth._tcp) and serve
+// cached frames at /frame on METRICS_PORT; see PeerCache.h. Give each unit
+// its own DEVICENAME so their .local names do not collide.
+#define PEER_CACHE_ENABLED   true  // Share frames with other units and ask them before ImageKit
+#define PEER_MAX                4  // Peers asked per frame
+#define PEER_REFRESH_MS    300000  // Interval between mDNS peer discoveries (ms)
+#define PEER_TIMEOUT_MS      1500  // Connect and read timeout for a peer request (ms)
+
+// ── Network bench (bench_network env) ────────────────────────────────────────
+#define BENCH_MAX_PASSES          6  // Backfill passes before giving up on the remaining slots
+#define BENCH_RETRY_WAIT_MS  ((MISS_BACKOFF_TRANSIENT_S + 1) * 1000)  // Pause after pass 1; doubles like the backoff (ms)
+
+// ── Decoder bench (bench_decoder env) ────────────────────────────────────────
+// The JPEG decoder backend is chosen per environment in platformio.ini
+// (JPEG_DECODER_JPEGDEC); see JpegDecoder.h.
+#define DECODER_BENCH_FRAMES     24  // Cached frames decoded per backend
+#define DECODER_BENCH_PASSES      3  // Decodes of each frame per backend
+
+// ── Render bench (native_render envs, host build) ───────────────────────────
+// The Arduino_GFX stand-in in src/host charges every bus transaction a fixed
+// cost plus the time to clock its bytes out. Clocks are the Arduino_GFX
+// driver defaults; the per-transaction costs are estimates — calibrate them
+// against avg_blit_us in /status from a real unit.
+#define RENDER_BENCH_PASSES             3  // Decodes of each frame
+#define RENDER_BENCH_REPLAYS         2000  // Replays of the last frame's blocks to time the blit call
+#define RENDER_BENCH_SPI_HZ      40000000  // GC9A01 SPI clock (Arduino_ESP32SPI default)
+#define RENDER_BENCH_SPI_TXN_NS       600  // Per transaction: DC/CS toggle and register setup (ns)
+#define RENDER_BENCH_SPI_TXN_BYTES     64  // Pixel bytes per transaction (the SPI data registers)
+#define RENDER_BENCH_QSPI_HZ     40000000  // SPD2010 QSPI clock (Arduino_ESP32QSPI default)
+#define RENDER_BENCH_QSPI_TXN_NS     8000  // Per transaction: spi_device_polling_transmit and DMA setup (ns)
+#define RENDER_BENCH_QSPI_TXN_BYTES  2048  // Pixel bytes per DMA transaction (1024 pixels)
+
+// ── Flash bench (bench_flash envs, and native_flash envs on the host) ───────
+// The LittleFS mount profile itself (cache, lookahead, block cycles) is set
+// per partition layout in platformio.ini ([littlefs_4MB], [littlefs_16MB]).
+#define FLASH_BENCH_MIN_BYTES     30000  // Smallest test file: a small frame (bytes)
+#define FLASH_BENCH_MAX_BYTES    100000  // Largest test file; sizes in between are spread evenly
+#define FLASH_BENCH_CHUNK         16384  // Bytes per write()/read() call
+#define FLASH_BENCH_SAMPLES          16  // Files timed per operation
+// NOR flash model of the host stand-in (src/host/LittleFS.h): what each
+// esp_partition call under esp_littlefs costs. Datasheet typicals for the
+// 25Q-series parts on both boards; calibrate them against bench_flash.
+#ifndef FLASH_BENCH_PARTITION_BYTES
+#define FLASH_BENCH_PARTITION_BYTES 0x270000  // LittleFS partition size (spiffs in partitions_4MB.csv)
+#endif
+#define FLASH_BENCH_CALL_NS           15000  // Per call: SPI flash op setup and cache disable (ns)
+#define FLASH_BENCH_READ_NS_PER_BYTE     50  // Read, about 20 MB/s (ns)
+#define FLASH_BENCH_PROG_NS_PER_BYTE   1600  // Page program, about 0.4 ms per 256 bytes (ns)
+#define FLASH_BENCH_ERASE_US          45000  // 4 KB sector erase (µs)
+
 // ── Time ─────────────────────────────────────────────────────────────────────
 #define NTP_SERVER         "pool.ntp.org"
 #define GMT_OFFSET_SEC     0   // UTC offset in seconds (e.g. GMT+2 = 7200).
@@ -60,8 +144,41 @@
 #define JPEG_QUALITY         70  // ImageKit resize quality (1–100).
                                  // Lower = smaller files, faster animation.
 #define DOWNLOAD_TIMEOUT_MS  5000 // Abort HTTP stream if no data arrives for this long (ms)
-#define UPDATE_INTERVAL_MS  10000 // Pause between main loop iterations (ms)
-#define FRAME_DELAY_MS        200 // Delay between animation frames in showLastXHours() (ms)
+#define DOWNLOAD_CHUNK_SIZE 16384 // Buffer growth step when the server sends no Content-Length (bytes)
+#define DOWNLOAD_RESUME_ATTEMPTS  2 // Immediate Range retries after a stall, while each one makes progress
+#define DOWNLOAD_RESUME_MIN_BYTES 4096 // Shorter partial bodies are not worth a flash write (bytes)
+#define STREAM_LATEST_FRAME  true // Draw the newest frame while it downloads (see ImageDownloader::streamLatest)
+#define URL_MAX_LEN           256 // Longest request URL, including IMAGEKIT_ENDPOINT (bytes)
+#define UPDATE_INTERVAL_MS  10000 // Pause between background sync passes (ms)
+#define FRAME_DELAY_MS        200 // Delay between animation frames at 100% speed (ms)
+
+// ── Playback ─────────────────────────────────────────────────────────────────
+#define PLAYBACK_HOLD_MS      UPDATE_INTERVAL_MS  // Pause on the newest frame before looping (ms)
+#define PLAYBACK_PINGPONG     false  // true = bounce at the ends instead of wrapping (long press toggles)
+#define PLAYBACK_DEFAULT_SPEED    2  // Index into the speed steps 25/50/100/200/400 % (2 = 100 %)
+#define PLAYBACK_TICK_MS         10  // loop() period — bounds touch-to-response latency (ms)
+#define ALLOC_AUDIT_REPORT_FRAMES 50  // alloc_audit builds: frames per allocation report
+
+// ── Read-ahead prefetch ──────────────────────────────────────────────────────
+// A background task reads the next frames in playback order from LittleFS
+// into a ring of RAM buffers while the current frame decodes. The depth is
+// recomputed every fill from free memory and the average cached frame size.
+#define PREFETCH_MAX_DEPTH             4  // Most frames held ahead (0 disables read-ahead)
+#define PREFETCH_RESERVE_PSRAM    524288  // PSRAM always left free for everything else (bytes)
+#define PREFETCH_RESERVE_INTERNAL 131072  // Internal heap always left free on boards without PSRAM (bytes)
+#define PREFETCH_FRAME_ESTIMATE    65536  // Frame size assumed while the cache index is empty (bytes)
+#define PREFETCH_TASK_STACK         4096  // Prefetch task stack (bytes)
+#define PREFETCH_TASK_PRIORITY         1  // Same priority as loopTask
+#define PREFETCH_TASK_CORE             0  // Beside WiFi; playback keeps core 1 to itself
+
+// ── Background sync task ─────────────────────────────────────────────────────
+#define SYNC_TASK_STACK      12288  // Sync task stack (bytes) — HTTPClient + TLS need headroom
+#define SYNC_TASK_PRIORITY       1  // Same priority as loopTask
+#define SYNC_TASK_CORE           0  // Beside WiFi; playback keeps core 1 to itself
+// Backfill runs coarse-to-fine: every Nth slot back from the newest, then the
+// slots halfway between, and so on down to every slot, so a cold cache plays
+// the whole window early and sharpens as it fills (see Timeline::backfillOrder).
+#define BACKFILL_COARSE_STRIDE   8  // First level's slot spacing; a power of two (1 = newest to oldest)
 
 // ── Satellite source ─────────────────────────────────────────────────────────
 // Set SATTYPE to the desired satellite — everything else is derived automatically.
@@ -74,11 +191,11 @@
 
 #define SATTYPE  METEOSAT  // ← only this line needs changing
 
-#define NROFIMAGESTOSHOW \
-    (SATTYPE == GOES_EAST || SATTYPE == GOES_WEST ? NROFIMAGES_GOES         : \
-     SATTYPE == ELEKTROL                          ? NROFIMAGES_ELEKTROL     : \
-     SATTYPE == METEOSAT                          ? NROFIMAGES_METEOSAT     : \
-                                                    NROFIMAGES_METEOSAT_IODC)
+#define SOURCE_STEP_MIN \
+    (SATTYPE == GOES_EAST || SATTYPE == GOES_WEST ? STEP_MIN_GOES         : \
+     SATTYPE == ELEKTROL                          ? STEP_MIN_ELEKTROL     : \
+     SATTYPE == METEOSAT                          ? STEP_MIN_METEOSAT     : \
+                                                    STEP_MIN_METEOSAT_IODC)
 
 #define RESIZEURL \
     (SATTYPE == GOES_EAST || SATTYPE == GOES_WEST ? RESIZEURL_GOES         : \
@@ -86,11 +203,35 @@
      SATTYPE == METEOSAT                          ? RESIZEURL_METEOSAT     : \
                                                     RESIZEURL_METEOSAT_IODC)
 
-// Number of images that cover 24 hours for each source
-#define NROFIMAGES_GOES          144  // GOES updates every 10 min  → 144 frames / 24 h
-#define NROFIMAGES_ELEKTROL       48  // ElektroL updates every 30 min → 48 frames / 24 h
-#define NROFIMAGES_METEOSAT       24  // EUMETSAT low-res updates every 60 min → 24 frames / 24 h
-#define NROFIMAGES_METEOSAT_IODC  24  // Same 60-min cadence as primary Meteosat
+// Update cadence of each source (minutes between images)
+#define STEP_MIN_GOES            10  // GOES updates every 10 min  → 144 frames / 24 h
+#define STEP_MIN_ELEKTROL        30  // ElektroL updates every 30 min → 48 frames / 24 h
+#define STEP_MIN_METEOSAT        60  // EUMETSAT low-res updates every 60 min → 24 frames / 24 h
+#define STEP_MIN_METEOSAT_IODC   60  // Same 60-min cadence as primary Meteosat
+
+// Animation window. The newest WINDOW_FULL_HOURS keep every image; older
+// history is sampled sparsely — one frame per WINDOW_MID_STEP_MIN back to
+// WINDOW_MID_HOURS, then one per WINDOW_FAR_STEP_MIN — so a week-long window
+// costs a few hundred frames instead of a thousand. Sparse slots sit on
+// round UTC times, so frames stay valid as the window slides.
+// GOES examples: 24 h (default) = 144 frames; 72 h ≈ 193; 168 h ≈ 225.
+#define WINDOW_HOURS          24  // Total history shown (e.g. 72 = 3 days, 168 = 7 days)
+#define WINDOW_FULL_HOURS     24  // Newest span kept at the source cadence
+#define WINDOW_MID_HOURS      72  // Hourly (WINDOW_MID_STEP_MIN) up to this age
+#define WINDOW_MID_STEP_MIN   60  // Spacing between WINDOW_FULL_HOURS and WINDOW_MID_HOURS (minutes)
+#define WINDOW_FAR_STEP_MIN  180  // Spacing beyond WINDOW_MID_HOURS (minutes)
+
+// Slots per zone; each sparse zone gets one extra for round-time alignment.
+#define WINDOW_MIN_(a, b) ((a) < (b) ? (a) : (b))
+#define WINDOW_FULL_SLOTS (WINDOW_MIN_(WINDOW_HOURS, WINDOW_FULL_HOURS) * 60 / SOURCE_STEP_MIN)
+#define WINDOW_MID_SLOTS \
+    (WINDOW_HOURS > WINDOW_FULL_HOURS ? \
+     (WINDOW_MIN_(WINDOW_HOURS, WINDOW_MID_HOURS) - WINDOW_FULL_HOURS) * 60 / WINDOW_MID_STEP_MIN + 1 : 0)
+#define WINDOW_FAR_SLOTS \
+    (WINDOW_HOURS > WINDOW_MID_HOURS ? (WINDOW_HOURS - WINDOW_MID_HOURS) * 60 / WINDOW_FAR_STEP_MIN + 1 : 0)
+
+// Maximum number of slots in the window.
+#define NROFIMAGESTOSHOW (WINDOW_FULL_SLOTS + WINDOW_MID_SLOTS + WINDOW_FAR_SLOTS)
 
 // ImageKit subfolder names (appended to IMAGEKIT_ENDPOINT in the request URL).
 // Each satellite needs its own ImageKit origin configured in the dashboard,
@@ -133,9 +274,53 @@
 // ── Image cache (LittleFS) ───────────────────────────────────────────────────
 // In-memory ring buffer — tracks recently cached timestamps.
 // Must be at least NROFIMAGESTOSHOW + 1.
-#define CACHE_SIZE 145
+#define CACHE_SIZE (NROFIMAGESTOSHOW + 1)
 
 // Trigger eviction of the oldest frame when LittleFS reaches this fraction full (percentage).
 #define CACHE_FILL_THRESHOLD 0.99f
 
+// Background flash writer — completed downloads are queued and written (and
+// evictions performed) on a separate task, off the download/display path.
+#define CACHE_WRITE_QUEUE_DEPTH       3  // Frames that may wait for the writer (each holds a JPEG copy)
+#define CACHE_WRITE_QUEUE_WAIT_MS 10000  // Max time cacheImage() blocks while the queue is full (ms)
+#define CACHE_FLUSH_TIMEOUT_MS     3000  // Max time to drain the queue before a restart (ms)
+#define CACHE_WRITER_STACK         6144  // Writer task stack (bytes)
+#define CACHE_WRITER_PRIORITY         1  // Same priority as loopTask
+#define CACHE_WRITER_CORE             0  // Run beside WiFi; the Arduino loop owns core 1
+#define CACHE_PURGE_BATCH            64  // Stale files collected per directory pass at boot
+
+// Tiered aging — instead of evicting old history when flash fills up, frames
+// older than CACHE_AGED_AFTER_MIN are re-fetched from ImageKit at
+// CACHE_AGED_QUALITY once usage passes CACHE_AGED_FILL_THRESHOLD. Eviction
+// (CACHE_FILL_THRESHOLD, above) then only starts once that tier is full.
+#define CACHE_TIERS                   2  // 0 = JPEG_QUALITY, 1 = CACHE_AGED_QUALITY
+#define CACHE_AGED_AFTER_MIN        360  // Age at which a frame may be demoted (minutes)
+#define CACHE_AGED_QUALITY           35  // ImageKit quality for demoted frames (1–100)
+#define CACHE_AGED_FILL_THRESHOLD 0.80f  // Start demoting at this fraction of LittleFS used
+#define CACHE_AGED_PER_PASS           8  // Max demotion attempts per sync pass (each is a download)
+
+// Pre-decoded frames — store each frame as run-length encoded RGB565 (.rle)
+// instead of JPEG once it has been shown, so later loops skip the JPEG decode.
+// Space and the area outside the disk collapse to a few runs; see FrameCodec.h.
+#define CACHE_RLE_FRAMES       false  // Transcode frames to .rle after first display
+#define RLE_BAND_LINES            16  // Rows buffered per band (one JPEG MCU row)
+#define RLE_BLACK_LEVEL            3  // Snap RGB565 values this close to black to 0 (0 = lossless)
+#define RLE_MIN_RUN                3  // Shorter repeats are stored as literal pixels
+#ifndef RLE_MAX_INTERNAL_BYTES
+#define RLE_MAX_INTERNAL_BYTES 65536  // Without PSRAM, frames encoding larger stay JPEG
+#endif
+
+// ── Negative cache (failed slots) ────────────────────────────────────────────
+// Slots that fail to download are not retried until their backoff expires.
+// Backoff doubles per consecutive failure; see MissCache::backoffSeconds().
+#define MISS_CACHE_SIZE              CACHE_SIZE  // Max failed slots remembered
+#define MISS_BACKOFF_NOTFOUND_S      300  // First retry after 404/410 (s)
+#define MISS_NOTFOUND_MAX_TRIES        5  // Give up on a slot after this many 404s
+#define MISS_BACKOFF_NOTMODIFIED_S   120  // Next poll after 304 / duplicate payload (s)
+#define MISS_BACKOFF_RATELIMIT_S     300  // First retry after 429 (s)
+#define MISS_BACKOFF_CLIENT_S       3600  // First retry after other 4xx (s)
+#define MISS_BACKOFF_TRANSIENT_S      30  // First retry after 5xx / timeout / no connection (s)
+#define MISS_BACKOFF_TRANSIENT_MAX_S 900  // Cap for transient failures (s)
+#define MISS_BACKOFF_MAX_S         21600  // Cap for all other failures (6 h)
+
 #endif
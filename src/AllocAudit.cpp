@@ -0,0 +1,63 @@
+// AllocAudit.cpp — heap allocation counter for the playback hot path.
+// Linked with -Wl,--wrap=malloc,--wrap=calloc,--wrap=realloc (see the
+// alloc_audit environment in platformio.ini).
+
+#ifdef ALLOC_AUDIT
+
+#include "AllocAudit.h"
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+extern "C" {
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t n, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+}
+
+static TaskHandle_t      _watched  = nullptr;
+static volatile uint32_t _app      = 0;
+static volatile uint32_t _fs       = 0;
+static volatile int      _fsDepth  = 0;  // Only the watched task changes this
+
+// Called for every allocation in the firmware, from any task and before the
+// scheduler starts, so it must stay trivial and must not allocate itself.
+static inline void count() {
+    if (!_watched || xTaskGetCurrentTaskHandle() != _watched) return;
+    if (_fsDepth > 0) _fs++;
+    else              _app++;
+}
+
+extern "C" {
+void *__wrap_malloc(size_t size) {
+    count();
+    return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t n, size_t size) {
+    count();
+    return __real_calloc(n, size);
+}
+
+// Every realloc() counts, growing or not — none should happen on the hot path.
+void *__wrap_realloc(void *ptr, size_t size) {
+    count();
+    return __real_realloc(ptr, size);
+}
+}
+
+void AllocAudit::watchCurrentTask() {
+    _watched = xTaskGetCurrentTaskHandle();
+}
+
+uint32_t AllocAudit::appAllocs() { return _app; }
+uint32_t AllocAudit::fsAllocs()  { return _fs; }
+
+void AllocAudit::enterFs() {
+    if (xTaskGetCurrentTaskHandle() == _watched) _fsDepth++;
+}
+
+void AllocAudit::leaveFs() {
+    if (xTaskGetCurrentTaskHandle() == _watched) _fsDepth--;
+}
+
+#endif
@@ -0,0 +1,140 @@
+// DecoderBench.cpp — on-device JPEG decoder benchmark (bench_decoder env only).
+
+#ifdef DECODER_BENCH
+
+#include "DecoderBench.h"
+#include "config.h"
+#include "Display.h"
+#include "ImageCache.h"
+#include "JpegDecoder.h"
+#include <LittleFS.h>
+#include <esp_heap_caps.h>
+
+// Results for one backend over all frames and passes.
+struct DecoderStats {
+    int      frames   = 0;
+    int      failed   = 0;
+    uint64_t decodeUs = 0;
+    uint64_t blitUs   = 0;
+    uint64_t tiles    = 0;           // Blocks handed to the output path
+    uint32_t minUs    = UINT32_MAX;  // Fastest / slowest single decode
+    uint32_t maxUs    = 0;
+    size_t   peakHeap = 0;           // Largest drop in free internal heap during a decode
+};
+
+static const int MAX_BACKENDS = 4;
+
+// Lowest free internal heap seen by the tile tap during the current decode.
+// Sampling from the tile callback catches whatever the decoder has allocated
+// while it is producing output.
+static size_t _minFree = 0;
+
+static void sampleHeap(int16_t, int16_t, uint16_t, uint16_t, const uint16_t *) {
+    size_t free = heap_caps_get_free_size(MALLOC_CAP_INTERNAL);
+    if (free < _minFree) _minFree = free;
+}
+
+// Timestamps of cached JPEG frames, newest last. RLE frames are skipped: they
+// involve no JPEG decode.
+static int listFrames(char keys[][16], int max) {
+    int  count = 0;
+    File dir   = LittleFS.open("/cache/" + String(SATTYPE_NAME));
+    if (!dir || !dir.isDirectory()) return 0;
+    for (File f = dir.openNextFile(); f && count < max; f = dir.openNextFile()) {
+        String name = String(f.name());
+        if (f.isDirectory() || !name.endsWith(".jpg")) continue;
+        strlcpy(keys[count++], name.substring(0, name.lastIndexOf('.')).c_str(), 16);
+    }
+    dir.close();
+    return count;
+}
+
+void runDecoderBench() {
+    Serial.println(F("\n=== Decoder bench ==="));
+    showStatus("Decoder bench...");
+
+    if (!cache.begin()) {
+        Serial.println(F("  Cache init failed"));
+        for (;;) delay(1000);
+    }
+
+    static char keys[DECODER_BENCH_FRAMES][16];
+    int frames = listFrames(keys, DECODER_BENCH_FRAMES);
+    if (frames == 0) {
+        Serial.println(F("  No cached JPEG frames — run the normal firmware first to record some"));
+        for (;;) delay(1000);
+    }
+
+    int backends = 0;
+    while (backends < MAX_BACKENDS && jpegBackend(backends)) backends++;
+    DecoderStats stats[MAX_BACKENDS];
+    for (int b = 0; b < backends; b++) jpegBackend(b)->begin();
+
+    // Frames outer, backends inner: each frame is read from flash once and
+    // every backend decodes the identical bytes.
+    size_t bytes = 0;
+    for (int i = 0; i < frames; i++) {
+        if (!cache.loadImage(keys[i])) continue;
+        bytes += imageSize;
+
+        for (int b = 0; b < backends; b++) {
+            JpegDecoder  *dec = jpegBackend(b);
+            DecoderStats &s   = stats[b];
+            for (int pass = 0; pass < DECODER_BENCH_PASSES; pass++) {
+                size_t before = heap_caps_get_free_size(MALLOC_CAP_INTERNAL);
+                _minFree = before;
+                setTileTap(sampleHeap);
+                takeBlitMicros();
+                takeBlitTiles();
+                uint32_t start = micros();
+                bool     ok    = dec->draw(0, 0, imageBuffer, imageSize);
+                uint32_t total = micros() - start;
+                uint32_t blit  = takeBlitMicros();
+                setTileTap(nullptr);
+
+                if (!ok) { s.failed++; continue; }
+                uint32_t decode = total - blit;
+                s.frames++;
+                s.decodeUs += decode;
+                s.blitUs   += blit;
+                s.tiles    += takeBlitTiles();
+                s.minUs     = min(s.minUs, decode);
+                s.maxUs     = max(s.maxUs, decode);
+                s.peakHeap  = max(s.peakHeap, before - _minFree);
+            }
+        }
+    }
+
+    Serial.printf("  %d frame(s), avg %d bytes, %d pass(es), %dx%d\n", frames,
+                  (int)(bytes / frames), DECODER_BENCH_PASSES, DISPLAY_WIDTH, DISPLAY_HEIGHT);
+    Serial.println(F("  Backend   decode ms (min-max)   blit ms   us/tile   total ms   peak heap   state"));
+    for (int b = 0; b < backends; b++) {
+        const DecoderStats &s = stats[b];
+        if (s.frames == 0) {
+            Serial.printf("  %-8s  all %d decodes failed\n", jpegBackend(b)->name(), s.failed);
+            continue;
+        }
+        float decodeMs = s.decodeUs / 1000.0f / s.frames;
+        float blitMs   = s.blitUs   / 1000.0f / s.frames;
+        float tileUs   = s.tiles ? (float)s.blitUs / s.tiles : 0.0f;
+        Serial.printf("  %-8s  %6.2f (%.2f-%.2f)   %7.2f   %7.2f   %8.2f   %7u B   %5u B%s\n",
+                      jpegBackend(b)->name(), decodeMs, s.minUs / 1000.0f, s.maxUs / 1000.0f,
+                      blitMs, tileUs, decodeMs + blitMs, (unsigned)s.peakHeap,
+                      (unsigned)jpegBackend(b)->stateBytes(),
+                      s.failed ? " (some decodes failed)" : "");
+    }
+    if (backends > 1 && stats[0].frames && stats[1].frames) {
+        float speedup = (float)(stats[0].decodeUs / stats[0].frames) /
+                        (float)(stats[1].decodeUs / stats[1].frames);
+        Serial.printf("  %s decodes %.2fx as fast as %s\n",
+                      jpegBackend(1)->name(), speedup, jpegBackend(0)->name());
+    }
+    Serial.printf("  Active backend in this build: %s, %s blit\n", jpegDecoder.name(),
+                  DISPLAY_DIRECT_BLIT ? "direct" : "Arduino_GFX");
+    Serial.println(F("====================="));
+
+    showStatus("Bench done", 0x07E0);
+    for (;;) delay(1000);
+}
+
+#endif
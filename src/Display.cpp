@@ -6,32 +6,136 @@
 #include "Display.h"
 #include "config.h"
 #include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
 
-// ── Bus and panel instantiation ───────────────────────────────────────────────
-// Both boards use the Arduino_GFX library; only the bus type and panel driver differ.
+// ── Display traits ────────────────────────────────────────────────────────────
+// Both boards use the Arduino_GFX library; only the bus type, panel driver and
+// geometry differ, and all three are fixed at compile time. Each board's
+// traits name the concrete classes, so the blit path below can bind its
+// calls statically instead of going through Arduino_GFX's virtual methods.
+
+struct Gc9a01Spi {};    // upesy_wroom / generic ESP32: GC9A01 over SPI
+struct Spd2010Qspi {};  // Waveshare ESP32-S3-Touch-LCD-1.46B: SPD2010 over QSPI
+
+template <typename Board> struct DisplayTraits;
+
+template <> struct DisplayTraits<Gc9a01Spi> {
+    typedef Arduino_ESP32SPI Bus;
+    typedef Arduino_GC9A01   Panel;
+    static constexpr int16_t WIDTH  = 240;
+    static constexpr int16_t HEIGHT = 240;
+
+    static Bus *makeBus() {
+        return new Bus(GC9A01_DC_PIN, GC9A01_CS_PIN, GC9A01_SCK_PIN, GC9A01_MOSI_PIN);
+    }
+    static Panel *makePanel(Bus *bus) { return new Panel(bus, GC9A01_RST_PIN); }
+};
+
+template <> struct DisplayTraits<Spd2010Qspi> {
+    typedef Arduino_ESP32QSPI Bus;
+    typedef Arduino_SPD2010   Panel;
+    static constexpr int16_t WIDTH  = 412;
+    static constexpr int16_t HEIGHT = 412;
+
+    static Bus *makeBus() {
+        return new Bus(WAVESHARE_CS_PIN, WAVESHARE_SCK_PIN,
+                       WAVESHARE_D0_PIN, WAVESHARE_D1_PIN,
+                       WAVESHARE_D2_PIN, WAVESHARE_D3_PIN);
+    }
+    static Panel *makePanel(Bus *bus) { return new Panel(bus, GFX_NOT_DEFINED); }
+};
 
 #ifdef BOARD_WAVESHARE
-Arduino_DataBus *_bus = new Arduino_ESP32QSPI(
-    WAVESHARE_CS_PIN,  WAVESHARE_SCK_PIN,
-    WAVESHARE_D0_PIN,  WAVESHARE_D1_PIN,
-    WAVESHARE_D2_PIN,  WAVESHARE_D3_PIN);
-Arduino_GFX *gfx = new Arduino_SPD2010(_bus, GFX_NOT_DEFINED);
+typedef DisplayTraits<Spd2010Qspi> Traits;
 #else
-Arduino_DataBus *_bus = new Arduino_ESP32SPI(
-    GC9A01_DC_PIN, GC9A01_CS_PIN, GC9A01_SCK_PIN, GC9A01_MOSI_PIN);
-Arduino_GFX *gfx = new Arduino_GC9A01(_bus, GC9A01_RST_PIN);
+typedef DisplayTraits<Gc9a01Spi> Traits;
 #endif
+static_assert(Traits::WIDTH == DISPLAY_WIDTH && Traits::HEIGHT == DISPLAY_HEIGHT,
+              "DISPLAY_WIDTH/HEIGHT do not match the board's panel");
+
+// ── Bus and panel instantiation ───────────────────────────────────────────────
+
+static Traits::Bus   *const _panelBus = Traits::makeBus();
+static Traits::Panel *const _panel    = Traits::makePanel(_panelBus);
+Arduino_DataBus *_bus = _panelBus;
+Arduino_GFX     *gfx  = _panel;
+
+// ── Blit path ─────────────────────────────────────────────────────────────────
+
+// The sequence Arduino_TFT::draw16bitRGBBitmap() runs for a block that lies
+// inside the panel, with every call qualified by its concrete class: no
+// virtual dispatch, and no clip tests beyond the one against the compile-time
+// geometry. The panel's own writeAddrWindow() is kept (rather than sending
+// CASET/RASET here) so its cached window stays correct for gfx's drawing.
+template <typename T>
+static inline void blitDirect(int16_t x, int16_t y, uint16_t w, uint16_t h, uint16_t *bitmap) {
+    typedef typename T::Bus   Bus;
+    typedef typename T::Panel Panel;
+    _panelBus->Bus::beginWrite();
+    _panel->Panel::writeAddrWindow(x, y, w, h);
+    _panelBus->Bus::writePixels(bitmap, (uint32_t)w * h);
+    _panelBus->Bus::endWrite();
+}
+
+static uint32_t _blitTiles = 0;
 
-// ── TJpg_Decoder callback ─────────────────────────────────────────────────────
+void blitToPanel(int16_t x, int16_t y, uint16_t w, uint16_t h, uint16_t *bitmap) {
+    _blitTiles++;
+    if (DISPLAY_DIRECT_BLIT && x >= 0 && y >= 0 &&
+        x + w <= Traits::WIDTH && y + h <= Traits::HEIGHT)
+        blitDirect<Traits>(x, y, w, h, bitmap);
+    else
+        gfx->draw16bitRGBBitmap(x, y, bitmap, w, h);
+}
+
+uint32_t takeBlitTiles() {
+    uint32_t tiles = _blitTiles;
+    _blitTiles = 0;
+    return tiles;
+}
+
+// ── JPEG decoder callback ─────────────────────────────────────────────────────
 
-// Called by TJpgDec once for every 16×16 pixel tile in the decoded JPEG.
+// Called by the active JPEG decoder backend once for every decoded block.
 // x/y is the tile's top-left corner on the display; bitmap is row-major RGB565.
 // Returning false would abort decoding early — always return true here.
+// Time spent in the panel driver is accumulated for takeBlitMicros().
+static uint32_t _blitMicros = 0;
+static TileTap  _tileTap    = nullptr;
+
 bool tft_output(int16_t x, int16_t y, uint16_t w, uint16_t h, uint16_t *bitmap) {
-    gfx->draw16bitRGBBitmap(x, y, bitmap, w, h);
+    if (_tileTap) _tileTap(x, y, w, h, bitmap);
+    uint32_t start = micros();
+    blitToPanel(x, y, w, h, bitmap);
+    _blitMicros += micros() - start;
     return true;
 }
 
+uint32_t takeBlitMicros() {
+    uint32_t us = _blitMicros;
+    _blitMicros = 0;
+    return us;
+}
+
+void setTileTap(TileTap tap) {
+    _tileTap = tap;
+}
+
+// ── Cross-task access ─────────────────────────────────────────────────────────
+
+// Recursive so a caller already holding the lock may still use showStatus().
+// Created in initDisplay(), before any task can draw.
+static SemaphoreHandle_t _displayMutex = nullptr;
+
+void lockDisplay() {
+    xSemaphoreTakeRecursive(_displayMutex, portMAX_DELAY);
+}
+
+void unlockDisplay() {
+    xSemaphoreGiveRecursive(_displayMutex);
+}
+
 // ── Boot status overlay ───────────────────────────────────────────────────────
 
 // Start a quarter of the way down so text lands in the wider middle of the
@@ -52,16 +156,20 @@ void showStatus(const char *msg, uint16_t color) {
     int16_t x = (DISPLAY_WIDTH - textWidth) / 2;
     if (x < 0) x = 0;  // clamp if the string is wider than the screen
 
+    lockDisplay();
     gfx->setTextSize(2);
     gfx->setTextColor(color);
     gfx->setCursor(x, _statusY);
     gfx->print(msg);
+    unlockDisplay();
     _statusY += lineHeight;
 }
 
 // ── Public initialisation ─────────────────────────────────────────────────────
 
 void initDisplay() {
+    _displayMutex = xSemaphoreCreateRecursiveMutex();
+
 #ifdef BOARD_WAVESHARE
     // The SPD2010 panel requires its power rail to be asserted via GPIO before
     // begin() is called; the display will remain dark without this.
@@ -0,0 +1,174 @@
+// FlashBench.cpp — LittleFS benchmark (bench_flash envs on the device,
+// native_flash envs on the host).
+
+#if defined(FLASH_BENCH) || defined(NATIVE_FLASH_BENCH)
+
+#include "FlashBench.h"
+#include "config.h"
+#include <LittleFS.h>
+
+#ifdef FLASH_BENCH
+#include "Display.h"
+#endif
+
+static const char BENCH_DIR[] = "/bench";
+
+static uint8_t _chunk[FLASH_BENCH_CHUNK];
+
+// On the host, littlefs runs on a fast CPU against the flash model, so its
+// own time says nothing about an ESP32: time the modeled flash instead.
+static uint32_t benchMicros() {
+#ifdef NATIVE_FLASH_BENCH
+    return LittleFS.modeledMicros();
+#else
+    return micros();
+#endif
+}
+
+static void benchPath(int i, const char *ext, char *out, size_t len) {
+    snprintf(out, len, "%s/%06d.%s", BENCH_DIR, i, ext);
+}
+
+// Sizes spread over [FLASH_BENCH_MIN_BYTES, FLASH_BENCH_MAX_BYTES), the same
+// sequence on every run, so profiles and boards see identical workloads.
+static size_t fileBytes(int i) {
+    return FLASH_BENCH_MIN_BYTES +
+           (uint32_t)i * 2654435761u % (FLASH_BENCH_MAX_BYTES - FLASH_BENCH_MIN_BYTES);
+}
+
+// ImageCache::writeFrame()'s pattern: write a .tmp file, close it, rename it
+// into place.
+static bool writeFile(int i, size_t bytes) {
+    char tmpPath[32], path[32];
+    benchPath(i, "tmp", tmpPath, sizeof(tmpPath));
+    benchPath(i, "jpg", path, sizeof(path));
+    File file = LittleFS.open(tmpPath, "w", true);
+    if (!file) return false;
+
+    size_t written = 0;
+    while (written < bytes) {
+        size_t n = min(bytes - written, sizeof(_chunk));
+        if (file.write(_chunk, n) != n) break;
+        written += n;
+    }
+    file.close();
+    return written == bytes && LittleFS.rename(tmpPath, path);
+}
+
+static bool readFile(int i, size_t *bytes) {
+    char path[32];
+    benchPath(i, "jpg", path, sizeof(path));
+    File file = LittleFS.open(path, "r");
+    if (!file) return false;
+
+    size_t total = 0, n;
+    while ((n = file.read(_chunk, sizeof(_chunk))) > 0) total += n;
+    file.close();
+    *bytes = total;
+    return true;
+}
+
+static void printOp(const char *name, const FlashOpStats &s) {
+    if (s.count == 0) return;
+    Serial.printf("  %-14s %5u %8.2f %8.2f %8.2f", name, (unsigned)s.count, s.avgMs(),
+                  s.minUs / 1000.0f, s.maxUs / 1000.0f);
+    if (s.bytes) Serial.printf(" %8.0f", s.kBps());
+    Serial.println();
+}
+
+bool runFlashSuite(FlashBenchResult &r) {
+    r = FlashBenchResult();
+    // LittleFS neither compresses nor dedups, so the content is irrelevant.
+    for (size_t i = 0; i < sizeof(_chunk); i++) _chunk[i] = (uint8_t)(i * 131 + 7);
+    if (!LittleFS.exists(BENCH_DIR) && !LittleFS.mkdir(BENCH_DIR)) return false;
+
+    // Fill to the cache's own limit, timing the first files on the empty
+    // filesystem.
+    const size_t limit = LittleFS.totalBytes() * CACHE_FILL_THRESHOLD;
+    int &files = r.files;
+    for (;; files++) {
+        size_t bytes = fileBytes(files);
+        if (LittleFS.usedBytes() + bytes > limit) break;
+        uint32_t start = benchMicros();
+        if (!writeFile(files, bytes)) return false;
+        if (files < FLASH_BENCH_SAMPLES) r.writeEmpty.add(benchMicros() - start, bytes);
+    }
+    if (files < FLASH_BENCH_SAMPLES) return false;
+
+    // Open and read files spread over the whole set, as playback does.
+    for (int k = 0; k < FLASH_BENCH_SAMPLES; k++) {
+        char path[32];
+        benchPath(k * files / FLASH_BENCH_SAMPLES, "jpg", path, sizeof(path));
+        uint32_t start = benchMicros();
+        File file = LittleFS.open(path, "r");
+        bool ok = (bool)file;
+        file.close();
+        r.open.add(benchMicros() - start);
+        if (!ok) return false;
+    }
+    for (int k = 0; k < FLASH_BENCH_SAMPLES; k++) {
+        size_t   bytes = 0;
+        uint32_t start = benchMicros();
+        if (!readFile(k * files / FLASH_BENCH_SAMPLES, &bytes)) return false;
+        r.read.add(benchMicros() - start, bytes);
+    }
+
+    // Steady state of a full cache: evict the oldest frame, write a new one.
+    for (int k = 0; k < FLASH_BENCH_SAMPLES; k++) {
+        char path[32];
+        benchPath(k, "jpg", path, sizeof(path));
+        uint32_t start = benchMicros();
+        if (!LittleFS.remove(path)) return false;
+        r.remove.add(benchMicros() - start);
+
+        size_t bytes = fileBytes(files + k);
+        start = benchMicros();
+        if (!writeFile(files + k, bytes)) return false;
+        r.writeFull.add(benchMicros() - start, bytes);
+    }
+
+    Serial.printf("  %d files of %d-%d bytes fill %u of %u KB\n", files,
+                  FLASH_BENCH_MIN_BYTES, FLASH_BENCH_MAX_BYTES,
+                  (unsigned)(LittleFS.usedBytes() / 1024), (unsigned)(LittleFS.totalBytes() / 1024));
+    Serial.println(F("  Operation      count   avg ms   min ms   max ms     KB/s"));
+    printOp("write (empty)", r.writeEmpty);
+    printOp("write (full)",  r.writeFull);
+    printOp("open",          r.open);
+    printOp("read",          r.read);
+    printOp("delete (full)", r.remove);
+    return true;
+}
+
+#ifdef FLASH_BENCH
+
+void runFlashBench() {
+    Serial.println(F("\n=== Flash bench ==="));
+    showStatus("Flash bench...");
+    Serial.printf("  LittleFS profile: read %d, prog %d, cache %d, lookahead %d, block cycles %d\n",
+                  CONFIG_LITTLEFS_READ_SIZE, CONFIG_LITTLEFS_WRITE_SIZE, CONFIG_LITTLEFS_CACHE_SIZE,
+                  CONFIG_LITTLEFS_LOOKAHEAD_SIZE, CONFIG_LITTLEFS_BLOCK_CYCLES);
+
+    // Every run starts from the same empty filesystem, so profiles compare.
+    LittleFS.begin(true);
+    LittleFS.format();
+    LittleFS.end();
+    if (!LittleFS.begin()) {
+        Serial.println(F("  LittleFS mount failed"));
+        for (;;) delay(1000);
+    }
+
+    FlashBenchResult result;
+    bool ok = runFlashSuite(result);
+    if (!ok) Serial.printf("  Filesystem operation failed after %d files\n", result.files);
+
+    // Hand the firmware an empty cache rather than a full one of test files.
+    LittleFS.format();
+    Serial.println(F("==================="));
+
+    showStatus(ok ? "Bench done" : "Bench FAILED", ok ? 0x07E0 : 0xF800);
+    for (;;) delay(1000);
+}
+
+#endif
+
+#endif
@@ -0,0 +1,268 @@
+// FrameCodec.cpp — display-native RLE RGB565 frame format.
+
+#include "FrameCodec.h"
+#include "config.h"
+#include "Display.h"
+#include <esp_heap_caps.h>
+#include <esp_rom_crc.h>
+
+static const uint32_t RLE_MAGIC = 0x36314C52;  // "RL16"
+
+// One band of RLE_BAND_LINES full-width rows, shared by the encoder (collecting
+// decoder tiles) and drawRleFrame() (expanding runs). Both only ever run on the
+// playback task and never at the same time. Allocated on first use so boards
+// that never see an RLE frame do not pay for it.
+static uint16_t *_band = nullptr;
+
+static bool reserveBand() {
+    if (!_band) _band = (uint16_t *)malloc(DISPLAY_WIDTH * RLE_BAND_LINES * sizeof(uint16_t));
+    return _band != nullptr;
+}
+
+// JPEG noise leaves space a speckle of almost-black values, which would break
+// every run. Snap them to true black; the difference is invisible on the panel.
+static inline uint16_t snapBlack(uint16_t px) {
+    if (RLE_BLACK_LEVEL == 0) return px;
+    uint16_t r = px >> 11, g = (px >> 5) & 0x3F, b = px & 0x1F;
+    return (r <= RLE_BLACK_LEVEL && g <= 2 * RLE_BLACK_LEVEL && b <= RLE_BLACK_LEVEL) ? 0 : px;
+}
+
+// ── Decoding ──────────────────────────────────────────────────────────────────
+
+bool isRleFrame(const uint8_t *data, size_t size) {
+    if (size < sizeof(RleHeader)) return false;
+    uint32_t magic;
+    memcpy(&magic, data, sizeof(magic));
+    return magic == RLE_MAGIC;
+}
+
+bool verifyRleFrame(const uint8_t *data, size_t size) {
+    if (!isRleFrame(data, size)) return false;
+    RleHeader h;
+    memcpy(&h, data, sizeof(h));
+    return h.width == DISPLAY_WIDTH && h.height <= DISPLAY_HEIGHT &&
+           esp_rom_crc32_le(0, data + sizeof(h), size - sizeof(h)) == h.payloadCrc;
+}
+
+// Walk the tokens without expanding them: true if they cover exactly <total>
+// pixels and every token lies inside [p, end). Much cheaper than the CRC,
+// and enough to guarantee the expansion below cannot fail half-way.
+static bool rleTokensValid(const uint8_t *p, const uint8_t *end, size_t total) {
+    size_t done = 0;
+    while (done < total && p + 2 <= end) {
+        uint16_t token;
+        memcpy(&token, p, 2);
+        p += 2;
+        size_t n = token & 0x7FFF;
+        if (n == 0 || n > total - done) return false;
+        size_t bytes = (token & 0x8000) ? 2 : 2 * n;
+        if ((size_t)(end - p) < bytes) return false;
+        p    += bytes;
+        done += n;
+    }
+    return done == total;
+}
+
+bool drawRleFrame(const uint8_t *data, size_t size, uint32_t *blitUs) {
+    if (!isRleFrame(data, size) || !reserveBand()) return false;
+    RleHeader h;
+    memcpy(&h, data, sizeof(h));
+    if (h.width != DISPLAY_WIDTH || h.height > DISPLAY_HEIGHT) return false;
+    // A malformed frame must fail before its first band reaches the panel.
+    if (!rleTokensValid(data + sizeof(h), data + size, (size_t)h.width * h.height)) return false;
+
+    const size_t   bandPixels = (size_t)h.width * RLE_BAND_LINES;
+    const size_t   total      = (size_t)h.width * h.height;
+    const uint8_t *p          = data + sizeof(h);
+    const uint8_t *end        = data + size;
+    size_t         done = 0, fill = 0;
+    int16_t        y = 0;
+
+    auto blit = [&](size_t pixels) {
+        uint16_t rows  = pixels / h.width;
+        uint32_t start = micros();
+        blitToPanel(0, y, h.width, rows, _band);
+        *blitUs += micros() - start;
+        y += rows;
+        fill = 0;
+    };
+
+    while (done < total && p + 2 <= end) {
+        uint16_t token;
+        memcpy(&token, p, 2);
+        p += 2;
+        size_t n   = token & 0x7FFF;
+        bool   run = token & 0x8000;
+        if (n == 0 || n > total - done) return false;
+
+        uint16_t px = 0;
+        if (run) {
+            if (p + 2 > end) return false;
+            memcpy(&px, p, 2);
+            p += 2;
+        } else if (p + 2 * n > end) {
+            return false;
+        }
+
+        while (n > 0) {
+            size_t take = min(n, bandPixels - fill);
+            if (run) {
+                for (size_t i = 0; i < take; i++) _band[fill + i] = px;
+            } else {
+                memcpy(_band + fill, p, take * 2);
+                p += take * 2;
+            }
+            fill += take;
+            done += take;
+            n    -= take;
+            if (fill == bandPixels) blit(fill);
+        }
+    }
+    if (fill > 0) blit(fill);
+    return done == total;
+}
+
+// ── Encoding ──────────────────────────────────────────────────────────────────
+
+// Output lives in PSRAM where fitted; it is handed to the cache writer as is.
+// It grows one band of raw pixels at a time and never past outMax.
+bool RleEncoder::reserve(size_t extra) {
+    if (outSize + extra <= outCap) return true;
+    if (outSize + extra > outMax) return false;
+    size_t cap   = min(max(outSize + extra, outCap + (size_t)width * RLE_BAND_LINES * 2), outMax);
+    void  *grown = psramFound() ? heap_caps_realloc(out, cap, MALLOC_CAP_SPIRAM) : realloc(out, cap);
+    if (!grown) return false;
+    out    = (uint8_t *)grown;
+    outCap = cap;
+    return true;
+}
+
+void RleEncoder::put16(uint16_t v) {
+    if (!out) return;
+    if (!reserve(2)) { abort(); return; }
+    memcpy(out + outSize, &v, 2);
+    outSize += 2;
+}
+
+bool RleEncoder::begin(uint16_t w, uint16_t h) {
+    abort();
+    if (w != DISPLAY_WIDTH || h > DISPLAY_HEIGHT || !reserveBand()) return false;
+    width    = w;
+    height   = h;
+    bandY    = -1;
+    bandRows = 0;
+    runLen   = 0;
+    litAt    = 0;
+    litLen   = 0;
+    outSize  = 0;
+    outCap   = 0;
+    // The format's worst case: every pixel a literal, plus a count word per
+    // 0x7FFF of them (a run token never costs more than the literals it
+    // replaces). Without PSRAM, internal RAM sets a tighter limit.
+    const size_t pixels = (size_t)w * h;
+    outMax = sizeof(RleHeader) + 2 * pixels + 2 * (pixels / 0x7FFF + 1);
+    if (!psramFound()) outMax = min(outMax, (size_t)RLE_MAX_INTERNAL_BYTES);
+    if (!reserve(sizeof(RleHeader))) { abort(); return false; }
+    outSize = sizeof(RleHeader);  // header is filled in by finish()
+    return true;
+}
+
+// Also clears the run, literal and band state, so nothing left over from the
+// aborted frame is written through a null <out> by finish().
+void RleEncoder::abort() {
+    free(out);
+    out      = nullptr;
+    outSize  = outCap = 0;
+    runLen   = 0;
+    litAt    = 0;
+    litLen   = 0;
+    bandY    = -1;
+    bandRows = 0;
+}
+
+void RleEncoder::closeLiteral() {
+    if (!out || litAt == 0) return;
+    memcpy(out + litAt, &litLen, 2);
+    litAt  = 0;
+    litLen = 0;
+}
+
+// A run shorter than RLE_MIN_RUN costs more as a run token than as literal
+// pixels, so it is folded into the open literal instead.
+void RleEncoder::closeRun() {
+    if (!out || runLen == 0) return;
+    if (runLen >= RLE_MIN_RUN) {
+        closeLiteral();
+        put16(0x8000 | runLen);
+        put16(runPixel);
+    } else {
+        for (uint16_t i = 0; i < runLen && out; i++) {
+            if (litAt == 0 || litLen == 0x7FFF) {
+                closeLiteral();
+                litAt = outSize;  // never 0: the header comes first
+                put16(0);
+            }
+            put16(runPixel);
+            litLen++;
+        }
+    }
+    runLen = 0;
+}
+
+void RleEncoder::pushPixel(uint16_t px) {
+    if (runLen > 0 && px == runPixel && runLen < 0x7FFF) {
+        runLen++;
+        return;
+    }
+    closeRun();
+    runPixel = px;
+    runLen   = 1;
+}
+
+void RleEncoder::flushBand() {
+    if (bandY < 0 || bandRows == 0) return;
+    const size_t pixels = (size_t)width * bandRows;
+    for (size_t i = 0; i < pixels && out; i++) pushPixel(snapBlack(_band[i]));
+    bandRows = 0;
+}
+
+void RleEncoder::addTile(int16_t x, int16_t y, uint16_t w, uint16_t h, const uint16_t *bitmap) {
+    if (!out) return;
+    if (h > RLE_BAND_LINES || y < bandY || x < 0 || x + w > width || y + h > height) {
+        abort();
+        return;
+    }
+    if (y != bandY) {
+        flushBand();
+        bandY = y;
+    }
+    if (h > bandRows) bandRows = h;
+    for (uint16_t row = 0; row < h; row++) {
+        memcpy(_band + (size_t)row * width + x, bitmap + (size_t)row * w, w * 2);
+    }
+}
+
+bool RleEncoder::finish(uint8_t **data, size_t *size) {
+    if (!out) return false;
+    uint16_t rowsSeen = bandY + bandRows;
+    flushBand();
+    if (!out) return false;  // outgrew outMax in the last band
+    closeRun();
+    closeLiteral();
+    if (!out || rowsSeen != height) {
+        abort();
+        return false;
+    }
+
+    RleHeader h = {RLE_MAGIC, width, height,
+                   esp_rom_crc32_le(0, out + sizeof(RleHeader), outSize - sizeof(RleHeader))};
+    memcpy(out, &h, sizeof(h));
+
+    // Give back the slack before the buffer sits in the write queue.
+    void *fit = psramFound() ? heap_caps_realloc(out, outSize, MALLOC_CAP_SPIRAM) : realloc(out, outSize);
+    *data   = fit ? (uint8_t *)fit : out;
+    *size   = outSize;
+    out     = nullptr;
+    outSize = outCap = 0;
+    return true;
+}
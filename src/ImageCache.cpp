@@ -2,23 +2,46 @@
 
 #include "ImageCache.h"
 #include "config.h"
-
-// imageBuffer and imageSize are owned by main.cpp and shared across all modules.
-extern uint8_t *imageBuffer;
-extern size_t   imageSize;
+#include "Metrics.h"
+#include "AllocAudit.h"
+#include "FrameCodec.h"
+#include "Timeline.h"
+#include <esp_rom_crc.h>
+#include <esp_heap_caps.h>
+#include <esp_system.h>
+#include <vector>
 
 // Single global instance used by ImageDownloader and main.
 ImageCache cache;
 
+// On-flash frame index header. Bump INDEX_VERSION whenever CacheEntry changes so
+// an old index is discarded instead of being misread.
+static const uint32_t INDEX_MAGIC   = 0x58444E49;  // "INDX"
+static const uint32_t INDEX_VERSION = 4;
+
+// esp_restart() shutdown hook: give the writer task a chance to persist
+// frames that are still queued before the chip resets.
+static void flushOnShutdown() {
+    cache.flush(CACHE_FLUSH_TIMEOUT_MS);
+}
+
 // ── Public methods ────────────────────────────────────────────────────────────
 
 // Mount LittleFS. If the first mount attempt fails (e.g. after a power loss that
-// left the filesystem in a bad state), format and retry once. Initialises the
-// in-memory ring buffer to all-invalid so loadImage() falls through to the
-// filesystem on every first lookup after a reboot.
+// left the filesystem in a bad state), format and retry once. Then load the
+// frame index for the active satellite.
 bool ImageCache::begin() {
     if (DEBUG_ENABLED) Serial.println("Initializing cache system...");
 
+    // Created before anything can fail: playback, metrics and peers may call
+    // in even when the cache never comes up.
+    lock       = xSemaphoreCreateMutex();
+    writeQueue = xQueueCreate(CACHE_WRITE_QUEUE_DEPTH, sizeof(WriteJob *));
+    if (!lock || !writeQueue) {
+        if (DEBUG_ENABLED) Serial.println("Cache lock/queue allocation failed");
+        return false;
+    }
+
     if (!LittleFS.begin(true)) {
         if (DEBUG_ENABLED) Serial.println("LittleFS mount failed, attempting format...");
         if (!LittleFS.format() || !LittleFS.begin()) {
@@ -31,166 +54,818 @@ bool ImageCache::begin() {
         Serial.printf("LittleFS: %d bytes total, %d used, %d free\n",
                       LittleFS.totalBytes(), LittleFS.usedBytes(),
                       LittleFS.totalBytes() - LittleFS.usedBytes());
+        // Mount profile from sdkconfig; see [littlefs_*] in platformio.ini.
+        Serial.printf("LittleFS profile: cache %d, lookahead %d, block cycles %d\n",
+                      CONFIG_LITTLEFS_CACHE_SIZE, CONFIG_LITTLEFS_LOOKAHEAD_SIZE,
+                      CONFIG_LITTLEFS_BLOCK_CYCLES);
     }
+    metrics.bootPhase("cache_mount");
 
     purgeStaleSatelliteCache();
+    metrics.bootPhase("stale_purge");
 
-    for (int i = 0; i < CACHE_SIZE; i++) entries[i].valid = false;
+    if (!LittleFS.exists("/cache")) LittleFS.mkdir("/cache");
+    String dir = "/cache/" + String(SATTYPE_NAME);
+    if (!LittleFS.exists(dir))      LittleFS.mkdir(dir);
+    loadIndex();
+    verifyCache();
+    metrics.bootPhase("cache_index");
+
+    // Flash writes (and the evictions they trigger) run on their own task so
+    // erase/program latency never stalls downloading or drawing.
+    if (xTaskCreatePinnedToCore(writerTask, "cacheWriter", CACHE_WRITER_STACK, this,
+                                CACHE_WRITER_PRIORITY, nullptr, CACHE_WRITER_CORE) != pdPASS) {
+        if (DEBUG_ENABLED) Serial.println("Cache writer task failed to start");
+        return false;
+    }
+    esp_register_shutdown_handler(flushOnShutdown);
+    started = true;
 
     if (DEBUG_ENABLED) Serial.println("Cache system initialized successfully");
     return true;
 }
 
+// Each pass over the directory collects up to CACHE_PURGE_BATCH paths, closes
+// it, then removes them. Removed files are not listed again, so the passes
+// together read each entry about once instead of restarting the listing after
+// every remove(). getNextFileName() reads the name without opening the file.
+int ImageCache::removeFiles(const char *dirPath, const char *prefix) {
+    char (*batch)[PATH_LEN] = (char (*)[PATH_LEN])malloc(CACHE_PURGE_BATCH * PATH_LEN);
+    if (!batch) return 0;
+    const size_t prefixLen = prefix ? strlen(prefix) : 0;
+    int removed = 0;
+
+    for (;;) {
+        File d = LittleFS.open(dirPath);
+        if (!d || !d.isDirectory()) break;
+
+        int n = 0;
+        bool isDir;
+        for (String p = d.getNextFileName(&isDir); p.length() && n < CACHE_PURGE_BATCH;
+             p = d.getNextFileName(&isDir)) {
+            if (isDir || p.length() >= sizeof(batch[0])) continue;
+            const char *name = strrchr(p.c_str(), '/');
+            name = name ? name + 1 : p.c_str();
+            if (prefix && strncmp(name, prefix, prefixLen) != 0) continue;
+            memcpy(batch[n++], p.c_str(), p.length() + 1);
+        }
+        d.close();
+
+        int gone = 0;
+        for (int i = 0; i < n; i++)
+            if (LittleFS.remove(batch[i])) gone++;
+        removed += gone;
+        // Stop once the listing ran out before the batch filled, or if nothing
+        // could be removed (the same paths would be collected again).
+        if (n < CACHE_PURGE_BATCH || gone == 0) break;
+    }
+    free(batch);
+    return removed;
+}
+
 // Delete all cached frames from satellite directories other than the active one.
-// Re-opens the directory on every iteration to avoid iterator invalidation when
-// files are removed. Runs once at boot — cost is proportional to stale file count.
+// Runs once at boot — cost is proportional to stale file count.
 void ImageCache::purgeStaleSatelliteCache() {
     // Remove named satellite subdirectories that don't match the active SATTYPE.
     const char* allSats[] = {"GOES_EAST", "GOES_WEST", "ElektroL", "Meteosat", "MeteosatIODC"};
     for (const char* sat : allSats) {
         if (strcmp(sat, SATTYPE_NAME) == 0) continue;
-        String dirPath = "/cache/" + String(sat);
+        char dirPath[PATH_LEN];
+        snprintf(dirPath, sizeof(dirPath), "/cache/%s", sat);
         if (!LittleFS.exists(dirPath)) continue;
 
-        int removed = 0;
-        bool found = true;
-        while (found) {
-            found = false;
-            File d = LittleFS.open(dirPath);
-            if (!d || !d.isDirectory()) break;
-            File f = d.openNextFile();
-            while (f) {
-                if (!f.isDirectory()) {
-                    String fp = String(f.path());
-                    f.close();
-                    d.close();
-                    LittleFS.remove(fp);
-                    removed++;
-                    found = true;
-                    break;
-                }
-                f = d.openNextFile();
-            }
-            if (d) d.close();
-        }
+        int removed = removeFiles(dirPath, nullptr);
         LittleFS.rmdir(dirPath);
         if (DEBUG_ENABLED)
             Serial.printf("Purged stale %s cache: %d files removed\n", sat, removed);
     }
 
+    // Remove per-satellite metadata (e.g. /meta/GOES_WEST.miss) for inactive
+    // satellites. Names are "<satellite>.<kind>", so match on the prefix + dot.
+    for (const char* sat : allSats) {
+        if (strcmp(sat, SATTYPE_NAME) == 0) continue;
+        char prefix[24];
+        snprintf(prefix, sizeof(prefix), "%s.", sat);
+        removeFiles("/meta", prefix);
+    }
+
     // Remove legacy flat files written directly into /cache/ by older firmware
     // (before satellite-namespaced subdirectories were introduced).
-    int legacy = 0;
-    bool found = true;
-    while (found) {
-        found = false;
-        File root = LittleFS.open("/cache");
-        if (!root || !root.isDirectory()) break;
-        File f = root.openNextFile();
-        while (f) {
-            if (!f.isDirectory()) {
-                String fp = String(f.path());
-                f.close();
-                root.close();
-                LittleFS.remove(fp);
-                legacy++;
-                found = true;
-                break;
-            }
-            f = root.openNextFile();
-        }
-        if (root) root.close();
-    }
+    int legacy = removeFiles("/cache", nullptr);
     if (DEBUG_ENABLED && legacy > 0)
         Serial.printf("Purged %d legacy flat cache files\n", legacy);
 }
 
-// Return the LittleFS path for a given timestamp under the active satellite's
-// subdirectory, e.g. /cache/GOES_EAST/20261081300.jpg. Creates the directory
-// hierarchy on first use so callers never need to worry about it.
-String ImageCache::getCachePath(const String& timestamp) {
-    if (!LittleFS.exists("/cache"))                        LittleFS.mkdir("/cache");
-    String dir = "/cache/" + String(SATTYPE_NAME);
-    if (!LittleFS.exists(dir))                             LittleFS.mkdir(dir);
-    return dir + "/" + timestamp + ".jpg";
+// Format the LittleFS path for a given timestamp under the active satellite's
+// subdirectory, e.g. /cache/GOES_EAST/20261081300.jpg. The directories are
+// created once in begin(), so this is pure string formatting.
+void ImageCache::getCachePath(const char* timestamp, bool rle, char *out, size_t len) {
+    snprintf(out, len, "/cache/%s/%s.%s", SATTYPE_NAME, timestamp, rle ? "rle" : "jpg");
 }
 
-// Write imageBuffer to LittleFS. If the filesystem is nearly full, evict the
-// oldest cached frame first to make room for this one.
-bool ImageCache::cacheImage(const String& timestamp) {
-    if (LittleFS.usedBytes() + imageSize > LittleFS.totalBytes() * CACHE_FILL_THRESHOLD) {
-        if (DEBUG_ENABLED) Serial.println("Cache full, evicting oldest frame...");
-        cleanup();
+void ImageCache::getTempPath(const char* timestamp, char *out, size_t len) {
+    snprintf(out, len, "/cache/%s/%s.tmp", SATTYPE_NAME, timestamp);
+}
+
+// ── Frame index ───────────────────────────────────────────────────────────────
+
+static String indexPath() {
+    return "/meta/" + String(SATTYPE_NAME) + ".idx";
+}
+
+void ImageCache::loadIndex() {
+    for (int i = 0; i < CACHE_SIZE; i++) entries[i].valid = false;
+    writeIndex = 0;
+    indexDirty = false;
+
+    if (!LittleFS.exists("/meta")) LittleFS.mkdir("/meta");
+
+    File file = LittleFS.open(indexPath(), "r");
+    if (!file) return;
+
+    uint32_t header[4] = {0, 0, 0, 0};  // magic, version, entry count, writeIndex
+    bool ok = file.read((uint8_t *)header, sizeof(header)) == sizeof(header) &&
+              header[0] == INDEX_MAGIC && header[1] == INDEX_VERSION &&
+              header[2] == CACHE_SIZE && header[3] < CACHE_SIZE &&
+              file.read((uint8_t *)entries, sizeof(entries)) == sizeof(entries);
+    file.close();
+
+    if (ok) {
+        writeIndex = header[3];
+        for (int i = 0; i < CACHE_SIZE; i++) entries[i].verified = false;
+    } else {
+        for (int i = 0; i < CACHE_SIZE; i++) entries[i].valid = false;
     }
+}
 
-    if (!imageBuffer || imageSize == 0) {
+void ImageCache::saveIndex() {
+    xSemaphoreTake(lock, portMAX_DELAY);
+    if (indexDirty) {
+        File file = LittleFS.open(indexPath(), "w", true);
+        if (file) {
+            uint32_t header[4] = {INDEX_MAGIC, INDEX_VERSION, CACHE_SIZE, (uint32_t)writeIndex};
+            file.write((const uint8_t *)header, sizeof(header));
+            file.write((const uint8_t *)entries, sizeof(entries));
+            file.close();
+            indexDirty = false;
+        } else if (DEBUG_ENABLED) {
+            Serial.println("Cannot write frame index");
+        }
+    }
+    xSemaphoreGive(lock);
+}
+
+int ImageCache::findEntry(const char* timestamp) {
+    for (int i = 0; i < CACHE_SIZE; i++) {
+        if (entries[i].valid && strcmp(entries[i].timestamp, timestamp) == 0) return i;
+    }
+    return -1;
+}
+
+// Pruned and discarded frames leave gaps in the ring; reuse those before
+// overwriting the entry written longest ago.
+int ImageCache::allocEntry() {
+    for (int k = 0; k < CACHE_SIZE; k++) {
+        int i = (writeIndex + k) % CACHE_SIZE;
+        if (!entries[i].valid) {
+            writeIndex = (i + 1) % CACHE_SIZE;
+            return i;
+        }
+    }
+    int i = writeIndex;
+    writeIndex = (writeIndex + 1) % CACHE_SIZE;
+    return i;
+}
+
+// Filenames are "<timestamp>.jpg" or ".rle"; strip the extension to get the index key.
+void ImageCache::forgetFile(const char* filename) {
+    char key[sizeof(entries[0].timestamp)];
+    strlcpy(key, filename, sizeof(key));
+    char *dot = strrchr(key, '.');
+    if (dot) *dot = '\0';
+
+    xSemaphoreTake(lock, portMAX_DELAY);
+    int i = findEntry(key);
+    if (i >= 0) {
+        entries[i].valid = false;
+        indexDirty = true;
+    }
+    xSemaphoreGive(lock);
+}
+
+// ESP32 ROM CRC32 — fast enough (a few ms per frame) to hash every download.
+uint32_t ImageCache::contentHash(const uint8_t *data, size_t size) {
+    return esp_rom_crc32_le(0, data, size);
+}
+
+// Only entries whose bytes were checked against their hash count: an
+// unknown hash (0) or one not yet verified since boot may belong to a file
+// that is about to fail its check, and the new frame would be lost with it.
+bool ImageCache::hasFrameWithHash(uint32_t hash) {
+    if (hash == 0) return false;
+    bool found = false;
+    xSemaphoreTake(lock, portMAX_DELAY);
+    for (int i = 0; i < CACHE_SIZE && !found; i++) {
+        found = entries[i].valid && entries[i].verified && entries[i].hash == hash;
+    }
+    for (WriteJob *job : pending) {
+        if (job && job->hash == hash) found = true;
+    }
+    xSemaphoreGive(lock);
+    return found;
+}
+
+bool ImageCache::contains(const char* timestamp) {
+    xSemaphoreTake(lock, portMAX_DELAY);
+    bool found = findEntry(timestamp) >= 0;
+    for (WriteJob *job : pending) {
+        if (job && strcmp(job->timestamp, timestamp) == 0) found = true;
+    }
+    xSemaphoreGive(lock);
+    return found;
+}
+
+// Walks the index once, placing each entry with a binary search of the window,
+// rather than searching the index once per slot.
+void ImageCache::cachedSlots(const Timeline& timeline, uint8_t *bits) {
+    memset(bits, 0, (timeline.count() + 7) / 8);
+    xSemaphoreTake(lock, portMAX_DELAY);
+    for (int i = 0; i < CACHE_SIZE; i++) {
+        if (!entries[i].valid) continue;
+        int slot = timeline.indexOf(entries[i].timestamp);
+        if (slot >= 0) bits[slot / 8] |= 1 << (slot % 8);
+    }
+    for (WriteJob *job : pending) {
+        if (!job) continue;
+        int slot = timeline.indexOf(job->timestamp);
+        if (slot >= 0) bits[slot / 8] |= 1 << (slot % 8);
+    }
+    xSemaphoreGive(lock);
+}
+
+void ImageCache::indexStats(int& frames, size_t& bytes) {
+    frames = 0;
+    bytes  = 0;
+    xSemaphoreTake(lock, portMAX_DELAY);
+    for (int i = 0; i < CACHE_SIZE; i++) {
+        if (!entries[i].valid) continue;
+        frames++;
+        bytes += entries[i].size;
+    }
+    xSemaphoreGive(lock);
+}
+
+uint32_t ImageCache::frameHash(const char* timestamp) {
+    xSemaphoreTake(lock, portMAX_DELAY);
+    int      i    = findEntry(timestamp);
+    uint32_t hash = i >= 0 ? entries[i].hash : 0;
+    for (WriteJob *job : pending) {
+        if (job && strcmp(job->timestamp, timestamp) == 0) hash = job->hash;
+    }
+    xSemaphoreGive(lock);
+    return hash;
+}
+
+int ImageCache::frameTier(const char* timestamp) {
+    xSemaphoreTake(lock, portMAX_DELAY);
+    int i    = findEntry(timestamp);
+    int tier = i >= 0 ? entries[i].tier : -1;
+    for (WriteJob *job : pending) {
+        if (job && strcmp(job->timestamp, timestamp) == 0) tier = job->tier;
+    }
+    xSemaphoreGive(lock);
+    return tier;
+}
+
+// ── Frame storage ─────────────────────────────────────────────────────────────
+
+// Copy the downloaded frame into a write job and hand it to the writer task.
+// PSRAM is preferred for the copy where fitted — it is plentiful and only the
+// writer reads it. If no RAM is left for the copy, fall back to a synchronous
+// write rather than losing the frame.
+bool ImageCache::cacheImage(const char* timestamp, const uint8_t *data, size_t size, uint32_t hash,
+                            uint8_t tier) {
+    if (!data || size == 0) {
         if (DEBUG_ENABLED) Serial.println("Invalid image buffer");
         return false;
     }
 
-    String path = getCachePath(timestamp);
-    File file = LittleFS.open(path, "w", true);
+    WriteJob *job  = (WriteJob *)malloc(sizeof(WriteJob));
+    uint8_t  *copy = nullptr;
+    if (job) copy = (uint8_t *)(psramFound() ? ps_malloc(size) : malloc(size));
+    if (!copy) {
+        free(job);
+        if (DEBUG_ENABLED) Serial.println("No RAM for write queue, writing synchronously");
+        return writeFrame(timestamp, data, size, hash, false, tier);
+    }
+
+    memcpy(copy, data, size);
+    strlcpy(job->timestamp, timestamp, sizeof(job->timestamp));
+    job->data = copy;
+    job->size = size;
+    job->hash = hash;
+    job->rle  = false;
+    job->tier = tier;
+
+    // Publish the job as pending before queueing it, so a loadImage() racing
+    // the writer always finds the frame either in RAM or on flash.
+    bool registered = false;
+    xSemaphoreTake(lock, portMAX_DELAY);
+    for (WriteJob *&slot : pending) {
+        if (!slot) { slot = job; registered = true; break; }
+    }
+    xSemaphoreGive(lock);
+
+    // Backpressure: if the writer has fallen behind, wait for it here instead
+    // of letting completed downloads pile up in RAM.
+    if (registered &&
+        xQueueSend(writeQueue, &job, pdMS_TO_TICKS(CACHE_WRITE_QUEUE_WAIT_MS)) == pdTRUE) {
+        return true;
+    }
+
+    if (DEBUG_ENABLED) Serial.printf("Write queue stalled, dropped %s\n", job->timestamp);
+    xSemaphoreTake(lock, portMAX_DELAY);
+    for (WriteJob *&slot : pending) {
+        if (slot == job) slot = nullptr;
+    }
+    xSemaphoreGive(lock);
+    free(copy);
+    free(job);
+    return false;
+}
+
+// The transcode is an optimisation, so every path that cannot queue it at once
+// just drops it. A frame still pending as a JPEG is skipped too: its index
+// entry (and hash) only exists once the writer has stored it.
+bool ImageCache::cacheTranscoded(const char* timestamp, uint8_t *data, size_t size) {
+    WriteJob *job = (WriteJob *)malloc(sizeof(WriteJob));
+    bool registered = false;
+
+    xSemaphoreTake(lock, portMAX_DELAY);
+    int  i    = findEntry(timestamp);
+    bool busy = false;
+    for (WriteJob *slot : pending) {
+        if (slot && strcmp(slot->timestamp, timestamp) == 0) busy = true;
+    }
+    if (job && i >= 0 && !entries[i].rle && entries[i].tier == 0 && !busy) {
+        strlcpy(job->timestamp, timestamp, sizeof(job->timestamp));
+        job->data = data;
+        job->size = size;
+        job->hash = entries[i].hash;
+        job->rle  = true;
+        job->tier = 0;
+        for (WriteJob *&slot : pending) {
+            if (!slot) { slot = job; registered = true; break; }
+        }
+    }
+    xSemaphoreGive(lock);
+
+    if (registered && xQueueSend(writeQueue, &job, 0) == pdTRUE) return true;
+
+    if (registered) {
+        xSemaphoreTake(lock, portMAX_DELAY);
+        for (WriteJob *&slot : pending) {
+            if (slot == job) slot = nullptr;
+        }
+        xSemaphoreGive(lock);
+    }
+    free(data);
+    free(job);
+    return false;
+}
+
+// Drain the write queue forever. The job stays in pending[] until its file is
+// complete so readers never see a gap between RAM and flash.
+void ImageCache::writerTask(void *arg) {
+    ImageCache *self = (ImageCache *)arg;
+    WriteJob   *job  = nullptr;
+
+    for (;;) {
+        if (xQueueReceive(self->writeQueue, &job, portMAX_DELAY) != pdTRUE) continue;
+
+        self->writeFrame(job->timestamp, job->data, job->size, job->hash, job->rle, job->tier);
+
+        xSemaphoreTake(self->lock, portMAX_DELAY);
+        for (WriteJob *&slot : self->pending) {
+            if (slot == job) slot = nullptr;
+        }
+        xSemaphoreGive(self->lock);
+        free(job->data);
+        free(job);
+    }
+}
+
+bool ImageCache::flush(uint32_t timeoutMs) {
+    if (!lock) return true;  // begin() never ran; nothing can be queued
+
+    unsigned long start = millis();
+    for (;;) {
+        bool busy = false;
+        xSemaphoreTake(lock, portMAX_DELAY);
+        for (WriteJob *job : pending) {
+            if (job) busy = true;
+        }
+        xSemaphoreGive(lock);
+
+        if (!busy) return true;
+        if (millis() - start > timeoutMs) return false;
+        delay(10);
+    }
+}
+
+// Write one frame to LittleFS. If the filesystem is nearly full, evict the
+// oldest cached frame first to make room for this one.
+bool ImageCache::writeFrame(const char* timestamp, const uint8_t *data, size_t size,
+                            uint32_t hash, bool rle, uint8_t tier) {
+    if (LittleFS.usedBytes() + size > LittleFS.totalBytes() * CACHE_FILL_THRESHOLD) {
+        if (DEBUG_ENABLED) Serial.println("Cache full, evicting oldest frame...");
+        cleanup(size);
+    }
+
+    // Write to a temporary name and rename into place: LittleFS renames are
+    // atomic, so <timestamp>.jpg is either absent or complete after a power cut.
+    char path[PATH_LEN], tmpPath[PATH_LEN];
+    getCachePath(timestamp, rle, path, sizeof(path));
+    getTempPath(timestamp, tmpPath, sizeof(tmpPath));
+    File file = LittleFS.open(tmpPath, "w", true);
     if (!file) {
-        if (DEBUG_ENABLED) { Serial.print("Cannot open for write: "); Serial.println(path); }
+        if (DEBUG_ENABLED) { Serial.print("Cannot open for write: "); Serial.println(tmpPath); }
         return false;
     }
 
-    size_t written = file.write(imageBuffer, imageSize);
+    size_t written = file.write(data, size);
     file.close();
 
-    if (written != imageSize) {
+    if (written != size || !LittleFS.rename(tmpPath, path)) {
         if (DEBUG_ENABLED) {
-            Serial.printf("Write incomplete: %d of %d bytes\n", written, imageSize);
+            Serial.printf("Write incomplete: %d of %d bytes\n", written, size);
         }
+        LittleFS.remove(tmpPath);
         return false;
     }
 
-    entries[writeIndex] = {timestamp, true};
-    writeIndex = (writeIndex + 1) % CACHE_SIZE;
+    indexFrame(timestamp, size, hash, rle, tier);
+    return true;
+}
+
+// Record a frame whose file is complete at its final path, and clean up what
+// it replaced. Shared by writeFrame() and commitStreamed().
+void ImageCache::indexFrame(const char* timestamp, size_t size, uint32_t hash, bool rle, uint8_t tier) {
+    xSemaphoreTake(lock, portMAX_DELAY);
+    int i = findEntry(timestamp);
+    CacheEntry previous = i >= 0 ? entries[i] : CacheEntry{};
+    if (i < 0) {
+        i = allocEntry();
+    }
+    strlcpy(entries[i].timestamp, timestamp, sizeof(entries[i].timestamp));
+    entries[i].size     = size;
+    entries[i].hash     = hash;
+    entries[i].valid    = true;
+    entries[i].verified = true;  // hash was computed from the bytes just written
+    entries[i].rle      = rle;
+    entries[i].tier     = tier;
+    indexDirty = true;
+    xSemaphoreGive(lock);
+
+    // The new file is in place and indexed; a copy in the other format (the
+    // JPEG an .rle was transcoded from, or an .rle being demoted to a small
+    // JPEG) is now dead weight. A power cut before this remove leaves both
+    // files, and verifyCache() deletes whichever one the saved index does not name.
+    if (previous.valid && previous.rle != rle) {
+        char path[PATH_LEN];
+        getCachePath(timestamp, previous.rle, path, sizeof(path));
+        LittleFS.remove(path);
+    }
+    if (previous.valid && tier > previous.tier) {
+        metrics.recordDemotion(previous.size > size ? previous.size - size : 0);
+    }
+
+    metrics.recordCacheWrite(size);
+    if (DEBUG_ENABLED) Serial.printf("Cached %s (%d bytes)\n", timestamp, size);
+}
+
+// ── Streamed frames ───────────────────────────────────────────────────────────
+
+bool ImageCache::hasRoomFor(size_t bytes) {
+    return LittleFS.usedBytes() + bytes <= LittleFS.totalBytes() * CACHE_FILL_THRESHOLD;
+}
 
-    if (DEBUG_ENABLED) Serial.printf("Cached %s (%d bytes)\n", timestamp.c_str(), written);
+// The same .tmp name the writer task uses; an interrupted stream is cleaned up
+// by verifyCache() at the next boot like any interrupted write.
+File ImageCache::openStreamed(const char* timestamp) {
+    char tmpPath[PATH_LEN];
+    getTempPath(timestamp, tmpPath, sizeof(tmpPath));
+    return LittleFS.open(tmpPath, "w", true);
+}
+
+bool ImageCache::commitStreamed(const char* timestamp, size_t size, uint32_t hash) {
+    char path[PATH_LEN], tmpPath[PATH_LEN];
+    getCachePath(timestamp, false, path, sizeof(path));
+    getTempPath(timestamp, tmpPath, sizeof(tmpPath));
+    if (!LittleFS.rename(tmpPath, path)) {
+        LittleFS.remove(tmpPath);
+        return false;
+    }
+    indexFrame(timestamp, size, hash, false, 0);
     return true;
 }
 
-// Load a cached JPEG into imageBuffer / imageSize.
-// Deletes the file and returns false if it exists but is zero-length (corrupt).
-bool ImageCache::loadImage(const String& timestamp) {
-    String path = getCachePath(timestamp);
-    if (!LittleFS.exists(path)) return false;
+void ImageCache::abortStreamed(const char* timestamp) {
+    char tmpPath[PATH_LEN];
+    getTempPath(timestamp, tmpPath, sizeof(tmpPath));
+    LittleFS.remove(tmpPath);
+}
 
+// Frames still in the write queue are not offered: the peer falls back to
+// another unit or the origin, and the frame is shareable a moment later.
+File ImageCache::openForPeer(const char* timestamp, uint8_t tier, uint32_t *hash) {
+    xSemaphoreTake(lock, portMAX_DELAY);
+    int  i     = findEntry(timestamp);
+    bool share = i >= 0 && !entries[i].rle && entries[i].tier == tier;
+    *hash      = share ? entries[i].hash : 0;
+    size_t size = share ? entries[i].size : 0;
+    xSemaphoreGive(lock);
+    if (!share) return File();
+
+    char path[PATH_LEN];
+    getCachePath(timestamp, false, path, sizeof(path));
     File file = LittleFS.open(path, "r");
+    if (file && file.size() != size) file.close();  // mid-rewrite; not worth serving
+    return file;
+}
+
+// Load buffers only ever grow: once the largest frame in the window has been
+// loaded, playback stops allocating altogether.
+static size_t _imageCapacity = 0;
+
+static bool reserveBuffer(FrameBuffer& buf, size_t bytes) {
+    if (bytes <= buf.capacity) return true;
+    void *grown = buf.psram ? heap_caps_realloc(buf.data, bytes, MALLOC_CAP_SPIRAM)
+                            : realloc(buf.data, bytes);
+    if (!grown) return false;
+    buf.data     = (uint8_t *)grown;
+    buf.capacity = bytes;
+    return true;
+}
+
+bool ImageCache::loadImage(const char* timestamp) {
+    FrameBuffer buf = {imageBuffer, _imageCapacity, imageSize, false};
+    bool ok = loadImage(timestamp, buf);
+    imageBuffer    = buf.data;
+    _imageCapacity = buf.capacity;
+    imageSize      = buf.size;
+    return ok;
+}
+
+// Load a cached frame (JPEG or RLE) into buf.
+// A frame still in the write queue is copied from RAM. Otherwise the file
+// length is checked against the index on every load. The content is checked
+// once, on the first load after boot: the CRC32 from the index, the RLE
+// payload CRC, or SOI/EOI for a frame without an index entry. A frame that
+// fails either check is deleted and the call returns false. A read error or a
+// failed allocation also returns false but keeps the file.
+bool ImageCache::loadImage(const char* timestamp, FrameBuffer& buf) {
+    bool fromQueue = false;
+    xSemaphoreTake(lock, portMAX_DELAY);
+    for (WriteJob *job : pending) {
+        if (!job || strcmp(job->timestamp, timestamp) != 0) continue;
+        if (reserveBuffer(buf, job->size)) {
+            memcpy(buf.data, job->data, job->size);
+            buf.size  = job->size;
+            fromQueue = true;
+        }
+        break;
+    }
+    xSemaphoreGive(lock);
+    if (fromQueue) return true;
+
+    CacheEntry expected = {};
+    xSemaphoreTake(lock, portMAX_DELAY);
+    int i = findEntry(timestamp);
+    if (i >= 0) expected = entries[i];
+    xSemaphoreGive(lock);
+
+    char path[PATH_LEN];
+    getCachePath(timestamp, expected.valid && expected.rle, path, sizeof(path));
+
+    // The VFS/LittleFS layer allocates its own handle and stdio buffer on every
+    // open; the allocation audit books those separately from our own.
+    File file;
+    {
+        FsAllocScope fs;
+        if (!LittleFS.exists(path)) return false;
+        file = LittleFS.open(path, "r");
+    }
     if (!file) return false;
 
-    imageSize = file.size();
-    if (imageSize == 0) {
+    // Length check: free, and catches every truncated write.
+    const size_t size = file.size();
+    if (size == 0 || (expected.valid && size != expected.size)) {
         file.close();
-        LittleFS.remove(path);  // remove corrupt empty file
+        discardFrame(timestamp, path, "length mismatch");
         return false;
     }
 
-    if (imageBuffer) free(imageBuffer);
-    imageBuffer = (uint8_t *)malloc(imageSize);
-    if (!imageBuffer) {
+    if (!reserveBuffer(buf, size)) {
         file.close();
         return false;
     }
 
-    file.read(imageBuffer, imageSize);
-    file.close();
+    size_t got;
+    {
+        FsAllocScope fs;
+        got = file.read(buf.data, size);
+        file.close();
+    }
+    if (got != size) return false;  // read error — keep the file, try again later
+    buf.size = size;
+    const uint8_t *data = buf.data;
+
+    if (expected.valid && expected.verified) return true;
+
+    // First load since boot (or a frame from older firmware): check the content
+    // once, then remember that it passed.
+    uint32_t hash = 0;
+    if (expected.valid && expected.rle) {
+        // The index keeps the source JPEG's hash; the RLE payload has its own CRC.
+        if (!verifyRleFrame(data, size)) {
+            discardFrame(timestamp, path, "RLE CRC mismatch");
+            return false;
+        }
+        hash = expected.hash;
+    } else if (expected.valid && expected.hash != 0) {
+        hash = contentHash(data, size);
+        if (hash != expected.hash) {
+            discardFrame(timestamp, path, "CRC mismatch");
+            return false;
+        }
+    } else {
+        bool jpeg = size >= 4 &&
+                    data[0] == 0xFF && data[1] == 0xD8 &&
+                    data[size - 2] == 0xFF && data[size - 1] == 0xD9;
+        if (!jpeg) {
+            discardFrame(timestamp, path, "missing SOI/EOI");
+            return false;
+        }
+        hash = contentHash(data, size);
+    }
+
+    xSemaphoreTake(lock, portMAX_DELAY);
+    i = findEntry(timestamp);
+    if (i < 0) {
+        i = allocEntry();
+        strlcpy(entries[i].timestamp, timestamp, sizeof(entries[i].timestamp));
+    }
+    entries[i].size     = size;
+    entries[i].hash     = hash;
+    entries[i].valid    = true;
+    entries[i].verified = true;
+    entries[i].rle      = expected.valid && expected.rle;
+    entries[i].tier     = expected.valid ? expected.tier : 0;
+    indexDirty = true;
+    xSemaphoreGive(lock);
     return true;
 }
 
+void ImageCache::discardFrame(const char* timestamp, const char* path, const char* reason) {
+    if (DEBUG_ENABLED) Serial.printf("Corrupt frame %s (%s), deleting\n", timestamp, reason);
+    LittleFS.remove(path);
+    xSemaphoreTake(lock, portMAX_DELAY);
+    int i = findEntry(timestamp);
+    if (i >= 0) { entries[i].valid = false; indexDirty = true; }
+    xSemaphoreGive(lock);
+}
+
+// Runs once from begin(), before the writer task exists, so no locking is needed.
+// Deletions are collected and performed after the directory walk so the
+// iterator is never invalidated. Both lists live on the heap: the loop task's
+// stack has no room for them, and any number of bad files must go.
+void ImageCache::verifyCache() {
+    File dir = LittleFS.open("/cache/" + String(SATTYPE_NAME));
+    if (!dir || !dir.isDirectory()) return;
+
+    std::vector<bool>   seen(CACHE_SIZE, false);
+    std::vector<String> doomed;
+    int                 adopted = 0;
+
+    for (File f = dir.openNextFile(); f; f = dir.openNextFile()) {
+        if (f.isDirectory()) continue;
+
+        String name = String(f.name());
+        String path = String(f.path());
+        size_t size = f.size();
+        String key  = name.substring(0, name.lastIndexOf('.'));
+        bool   rle  = name.endsWith(".rle");
+        bool   bad  = false;
+
+        int i = findEntry(key.c_str());
+        if (name.endsWith(".tmp")) {
+            bad = true;  // interrupted write
+        } else if (i >= 0 && entries[i].rle != rle) {
+            // A transcode was cut short: either both files exist (keep the one
+            // the index names) or the index was not saved after the .jpg went
+            // (follow the file). The hash is the JPEG's in both cases.
+            char other[PATH_LEN];
+            getCachePath(key.c_str(), !rle, other, sizeof(other));
+            bad = LittleFS.exists(other);
+            if (!bad) {
+                seen[i] = true;
+                entries[i].size     = size;
+                entries[i].rle      = rle;
+                indexDirty = true;
+            }
+        } else if (i >= 0) {
+            seen[i] = true;
+            bad = size != entries[i].size;
+            if (bad) entries[i].valid = false;
+        } else if (rle) {
+            // Unindexed RLE frame: the header is enough; the payload CRC is
+            // checked on first load.
+            RleHeader header;
+            bad = f.read((uint8_t *)&header, sizeof(header)) != sizeof(header) ||
+                  !isRleFrame((const uint8_t *)&header, sizeof(header)) ||
+                  header.width != DISPLAY_WIDTH;
+        } else {
+            // Unindexed (older firmware or index lost): peek at the first and
+            // last two bytes only.
+            uint8_t head[2] = {0, 0}, tail[2] = {0, 0};
+            bad = size < 4 || f.read(head, 2) != 2 || !f.seek(size - 2) || f.read(tail, 2) != 2 ||
+                  head[0] != 0xFF || head[1] != 0xD8 || tail[0] != 0xFF || tail[1] != 0xD9;
+        }
+        if (i < 0 && !bad) {
+            i = allocEntry();
+            strlcpy(entries[i].timestamp, key.c_str(), sizeof(entries[i].timestamp));
+            entries[i].size     = size;
+            entries[i].hash     = 0;  // computed on first load
+            entries[i].valid    = true;
+            entries[i].verified = false;
+            entries[i].rle      = rle;
+            entries[i].tier     = 0;  // unknown; treated as full quality
+            seen[i]    = true;
+            indexDirty = true;
+            adopted++;
+        }
+        f.close();
+
+        if (bad) {
+            doomed.push_back(path);
+            indexDirty = true;
+        }
+    }
+    dir.close();
+
+    for (const String &path : doomed) LittleFS.remove(path);
+
+    // Index entries whose file has disappeared.
+    for (int i = 0; i < CACHE_SIZE; i++) {
+        if (entries[i].valid && !seen[i]) {
+            entries[i].valid = false;
+            indexDirty = true;
+        }
+    }
+
+    if (DEBUG_ENABLED && (!doomed.empty() || adopted > 0))
+        Serial.printf("Cache verify: %u bad file(s) removed, %d frame(s) adopted\n",
+                      (unsigned)doomed.size(), adopted);
+}
+
+// One stale entry is claimed per lock hold and its file removed outside the
+// lock, so playback never waits on a flash erase.
+int ImageCache::pruneOutsideWindow(const Timeline& timeline) {
+    if (timeline.count() == 0) return 0;
+    int removed = 0;
+
+    for (int i = 0; i < CACHE_SIZE; i++) {
+        char path[PATH_LEN];
+        bool stale = false;
+        xSemaphoreTake(lock, portMAX_DELAY);
+        if (entries[i].valid && timeline.indexOf(entries[i].timestamp) < 0) {
+            getCachePath(entries[i].timestamp, entries[i].rle, path, sizeof(path));
+            entries[i].valid = false;
+            indexDirty = true;
+            stale = true;
+        }
+        xSemaphoreGive(lock);
+
+        if (stale && LittleFS.remove(path)) removed++;
+    }
+
+    if (DEBUG_ENABLED && removed > 0)
+        Serial.printf("Pruned %d frame(s) outside the window\n", removed);
+    return removed;
+}
+
 // Evict enough old frames to make room for one incoming image.
 // Scans ALL satellite subdirectories under /cache/ so that switching satellites
 // (or upgrading from the old flat /cache/<timestamp>.jpg layout) never leaves
 // stale files from another source blocking eviction. The oldest file by filename
 // across the whole tree is removed each pass.
-void ImageCache::cleanup() {
+void ImageCache::cleanup(size_t bytesNeeded) {
     if (DEBUG_ENABLED) {
         Serial.printf("Cache cleanup — used before: %d bytes\n", LittleFS.usedBytes());
     }
 
-    size_t targetUsage = LittleFS.totalBytes() - imageSize;
+    size_t targetUsage = LittleFS.totalBytes() - bytesNeeded;
     int    removed     = 0;
 
     while (LittleFS.usedBytes() > targetUsage) {
@@ -232,18 +907,17 @@ void ImageCache::cleanup() {
         if (oldestPath.isEmpty()) break;
 
         if (LittleFS.remove(oldestPath)) {
+            // Only frames of the active satellite are in the index.
+            if (oldestPath.startsWith("/cache/" + String(SATTYPE_NAME) + "/"))
+                forgetFile(oldestName.c_str());
             removed++;
+            metrics.recordEviction();
             if (DEBUG_ENABLED) Serial.printf("Evicted: %s\n", oldestPath.c_str());
         } else {
             break;  // stop if a removal fails to avoid an infinite loop
         }
     }
 
-    // Invalidate the in-memory ring buffer so subsequent loadImage() calls
-    // consult the filesystem rather than stale metadata.
-    for (int i = 0; i < CACHE_SIZE; i++) entries[i].valid = false;
-    writeIndex = 0;
-
     if (DEBUG_ENABLED) {
         Serial.printf("Cache cleanup done — removed %d file(s), used after: %d bytes\n",
                       removed, LittleFS.usedBytes());
@@ -251,10 +925,12 @@ void ImageCache::cleanup() {
 }
 
 // Scan /cache/, count files and their total size, then print a summary with a
-// suggestion so the user knows whether JPEG_QUALITY or NROFIMAGESTOSHOW can be tuned.
+// suggestion so the user knows whether JPEG_QUALITY or WINDOW_HOURS can be tuned.
 void ImageCache::printStats() {
     int    fileCount = 0;
-    size_t dataBytes = 0;  // sum of actual JPEG sizes (not filesystem overhead)
+    size_t dataBytes = 0;  // sum of actual frame sizes (not filesystem overhead)
+    int    rleCount  = 0;  // of which pre-decoded .rle frames
+    size_t rleBytes  = 0;
 
     File dir = LittleFS.open("/cache/" + String(SATTYPE_NAME));
     if (dir && dir.isDirectory()) {
@@ -263,6 +939,10 @@ void ImageCache::printStats() {
             if (!f.isDirectory()) {
                 fileCount++;
                 dataBytes += f.size();
+                if (String(f.name()).endsWith(".rle")) {
+                    rleCount++;
+                    rleBytes += f.size();
+                }
             }
             f = dir.openNextFile();
         }
@@ -280,21 +960,46 @@ void ImageCache::printStats() {
     Serial.printf("  Frames cached : %d\n",          fileCount);
     Serial.printf("  Avg frame size: %d bytes\n",     avgSize);
     Serial.printf("  Max frames fit: ~%d\n",          maxFrames);
+
+    // Aged tier, from the index (the directory listing cannot tell the tiers apart).
+    int    agedCount = 0;
+    size_t agedBytes = 0;
+    xSemaphoreTake(lock, portMAX_DELAY);
+    for (int i = 0; i < CACHE_SIZE; i++) {
+        if (!entries[i].valid || entries[i].tier == 0) continue;
+        agedCount++;
+        agedBytes += entries[i].size;
+    }
+    xSemaphoreGive(lock);
+    if (agedCount > 0)
+        Serial.printf("  Aged frames   : %d at q-%d, avg %d bytes\n",
+                      agedCount, CACHE_AGED_QUALITY, agedBytes / agedCount);
+
+    if (rleCount > 0) {
+        // Compare the formats directly: how many frames of each would fit.
+        int    jpgCount = fileCount - rleCount;
+        size_t jpgAvg   = jpgCount > 0 ? (dataBytes - rleBytes) / jpgCount : 0;
+        size_t rleAvg   = rleBytes / rleCount;
+        Serial.printf("  JPEG frames   : %d, avg %d bytes, ~%d fit\n", jpgCount, jpgAvg,
+                      jpgAvg > 0 ? (int)(fsTotal * CACHE_FILL_THRESHOLD / jpgAvg) : 0);
+        Serial.printf("  RLE frames    : %d, avg %d bytes, ~%d fit\n", rleCount, rleAvg,
+                      (int)(fsTotal * CACHE_FILL_THRESHOLD / rleAvg));
+    }
     Serial.printf("  LittleFS used : %d KB / %d KB (%.1f%% full, %d KB free)\n",
                   fsUsed / 1024, fsTotal / 1024, fillPct, fsFree / 1024);
 
     // Give an actionable suggestion based on how full the cache is.
     if (fillPct < 60.0f) {
         Serial.println(F("  Tip: Cache has plenty of room."));
-        Serial.printf( "       Try raising JPEG_QUALITY above %d, or increasing NROFIMAGESTOSHOW.\n", JPEG_QUALITY);
+        Serial.printf( "       Try raising JPEG_QUALITY above %d, or lengthening WINDOW_HOURS.\n", JPEG_QUALITY);
     } else if (fillPct < 85.0f) {
         Serial.println(F("  Tip: Cache usage is healthy — no changes needed."));
     } else if (fillPct < 95.0f) {
         Serial.println(F("  Tip: Cache is getting full."));
-        Serial.printf( "       Consider lowering JPEG_QUALITY below %d, or reducing NROFIMAGESTOSHOW.\n", JPEG_QUALITY);
+        Serial.printf( "       Consider lowering JPEG_QUALITY below %d, or shortening WINDOW_HOURS.\n", JPEG_QUALITY);
     } else {
         Serial.println(F("  Tip: Cache is nearly full — evictions are likely every cycle."));
-        Serial.printf( "       Lower JPEG_QUALITY below %d or reduce NROFIMAGESTOSHOW.\n", JPEG_QUALITY);
+        Serial.printf( "       Lower JPEG_QUALITY below %d or shorten WINDOW_HOURS.\n", JPEG_QUALITY);
     }
     Serial.println(F("===================\n"));
 }
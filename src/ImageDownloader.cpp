@@ -1,79 +1,93 @@
-// ImageDownloader.cpp — satellite image retrieval and 24-hour animation playback.
+// ImageDownloader.cpp — satellite image retrieval and background cache sync.
 
 #include "ImageDownloader.h"
 #include "config.h"
-#include <TJpg_Decoder.h>
+#include "MissCache.h"
+#include "Metrics.h"
+#include "Timeline.h"
+#include "WiFiManager.h"
+#include "Display.h"
+#include "JpegDecoder.h"
+#include "Playback.h"
+#include "PeerCache.h"
+#include <LittleFS.h>
+#include <esp_rom_crc.h>
+
+String   ImageDownloader::etag;
+String   ImageDownloader::lastModified;
+bool     ImageDownloader::validatorsLoaded = false;
+uint8_t *ImageDownloader::downloadBuffer   = nullptr;
+size_t   ImageDownloader::downloadCapacity = 0;
+size_t   ImageDownloader::downloadSize     = 0;
+size_t   ImageDownloader::resumeTotal      = 0;
+char     ImageDownloader::resumeValidator[80] = "";
+char     ImageDownloader::partialTimestamp[16] = "";
+uint8_t  ImageDownloader::partialTier      = 0;
+bool     ImageDownloader::partialChecked   = false;
 
 // ── Private helpers ───────────────────────────────────────────────────────────
 
-// Format a normalised tm struct as the timestamp string for the active source.
-// GOES East/West: "YYYYDDDHHMM"   — day-of-year, minutes snapped to nearest 10.
-// ElektroL:       "YYYYMMDD-HHMM" — calendar date, minutes snapped to nearest 30.
-// Meteosat:       "YYYYMMDD-HHMM" — calendar date, minutes snapped to nearest 15.
-//                 Used only as a cache key; the download URL is always the static
-//                 "latest" EUMETSAT image and does not embed the timestamp.
-String ImageDownloader::formatTimestamp(const struct tm &t)
+// The parts of every URL that never change for a given build — endpoint,
+// resize transform, source path, and filename suffix — are formatted once on
+// first use. Per-frame URL construction is then a single snprintf into the
+// caller's buffer, with no temporary Strings on a heap shared with JPEG buffers.
+// Each cache tier has its own prefix, differing only in the quality parameter.
+static const uint8_t TIER_QUALITY[CACHE_TIERS] = {JPEG_QUALITY, CACHE_AGED_QUALITY};
+static char _urlPrefix[CACHE_TIERS][URL_MAX_LEN];  // Everything before the timestamp
+static char _urlSuffix[48];                        // Everything after it
+
+static void buildUrlPrefix(char *prefix, size_t len, uint8_t quality)
 {
-    char buf[22];
     switch (SATTYPE)
     {
+    case GOES_EAST:
+    case GOES_WEST:
+        snprintf(prefix, len, "%s%str:w-%d,h-%d,q-%d/%s",
+                 IMAGEKIT_ENDPOINT, RESIZEURL_GOES, DISPLAY_WIDTH, DISPLAY_HEIGHT, quality,
+                 SATTYPE == GOES_EAST ? BASE_URL_EAST : BASE_URL_WEST);
+        snprintf(_urlSuffix, sizeof(_urlSuffix), "_%s-ABI-FD-GEOCOLOR-%dx%d.jpg",
+                 SATTYPE == GOES_EAST ? "GOES19" : "GOES18", GOES_SOURCE_SIZE, GOES_SOURCE_SIZE);
+        break;
     case ELEKTROL:
-        snprintf(buf, sizeof(buf), "%04d%02d%02d-%02d%02d",
-                 t.tm_year + 1900,
-                 t.tm_mon + 1,
-                 t.tm_mday,
-                 t.tm_hour,
-                 (t.tm_min / 30) * 30); // snap to 0 or 30
+        snprintf(prefix, len, "%s%str:w-%d,h-%d,q-%d/",
+                 IMAGEKIT_ENDPOINT, RESIZEURL_ELEKTROL, DISPLAY_WIDTH, DISPLAY_HEIGHT, quality);
+        strlcpy(_urlSuffix, ".jpg", sizeof(_urlSuffix));
         break;
     case METEOSAT:
     case METEOSAT_IODC:
-        snprintf(buf, sizeof(buf), "%04d%02d%02d-%02d00",
-                 t.tm_year + 1900,
-                 t.tm_mon + 1,
-                 t.tm_mday,
-                 t.tm_hour); // snap to hour boundary — low-res image updates every 60 min
-        break;
-    case GOES_EAST:
-    case GOES_WEST:
-    default:
-        snprintf(buf, sizeof(buf), "%d%03d%04d",
-                 t.tm_year + 1900,
-                 t.tm_yday + 1,                           // day-of-year, 1-based
-                 t.tm_hour * 100 + (t.tm_min / 10) * 10); // HHMM, snapped to 10-min
+        // Crop out EUMETSAT's border/label area before resizing to the display
+        // dimensions. METEOSAT_CROP_SIZE defines the intermediate square extracted
+        // from the centre of the full image; ImageKit then scales it down to
+        // DISPLAY_WIDTH × DISPLAY_HEIGHT. Adjust METEOSAT_CROP_SIZE in config.h
+        // to tighten or loosen the crop without changing any other settings.
+        snprintf(prefix, len,
+                 "%s%str:w-%d,h-%d,cm-extract:w-%d,h-%d,q-%d/%s?ik-cache-bust=",
+                 IMAGEKIT_ENDPOINT,
+                 SATTYPE == METEOSAT_IODC ? RESIZEURL_METEOSAT_IODC : RESIZEURL_METEOSAT,
+                 METEOSAT_CROP_SIZE, METEOSAT_CROP_SIZE, DISPLAY_WIDTH, DISPLAY_HEIGHT, quality,
+                 SATTYPE == METEOSAT_IODC ? METEOSAT_IODC_IMAGE_FILE : METEOSAT_IMAGE_FILE);
+        _urlSuffix[0] = '\0';
         break;
     }
-    return String(buf);
 }
 
-// Build the full ImageKit proxy URL for a given timestamp.
+static void buildUrlParts()
+{
+    for (uint8_t tier = 0; tier < CACHE_TIERS; tier++)
+        buildUrlPrefix(_urlPrefix[tier], sizeof(_urlPrefix[tier]), TIER_QUALITY[tier]);
+}
+
+// Build the full ImageKit proxy URL for a given timestamp and cache tier.
 // ImageKit applies the resize transform (width, height, quality) server-side
 // before returning the JPEG, so the ESP32 never handles the full-res image.
-String ImageDownloader::constructUrl(const String &timestamp)
+bool ImageDownloader::constructUrl(const char *timestamp, uint8_t tier, char *out, size_t len)
 {
-    String resize = "tr:w-" + String(DISPLAY_WIDTH) +
-                    ",h-" + String(DISPLAY_HEIGHT) +
-                    ",q-" + String(JPEG_QUALITY) + "/";
-    switch (SATTYPE)
-    {
-    case GOES_EAST:
-    {
-        String suffix = "_GOES19-ABI-FD-GEOCOLOR-" + String(GOES_SOURCE_SIZE) +
-                        "x" + String(GOES_SOURCE_SIZE) + ".jpg";
-        return String(IMAGEKIT_ENDPOINT) + RESIZEURL + resize +
-               BASE_URL_EAST + timestamp + suffix;
-    }
-    case GOES_WEST:
+    const char *prefix = _urlPrefix[tier];
+    if (!prefix[0])
+        buildUrlParts();
+
+    if (isLatestOnlySource())
     {
-        String suffix = "_GOES18-ABI-FD-GEOCOLOR-" + String(GOES_SOURCE_SIZE) +
-                        "x" + String(GOES_SOURCE_SIZE) + ".jpg";
-        return String(IMAGEKIT_ENDPOINT) + RESIZEURL + resize +
-               BASE_URL_WEST + timestamp + suffix;
-    }
-    case ELEKTROL:
-        return String(IMAGEKIT_ENDPOINT) + RESIZEURL_ELEKTROL + resize +
-               timestamp + ".jpg";
-    case METEOSAT:
-    case METEOSAT_IODC:
         // EUMETSAT publishes one static filename per satellite that is overwritten
         // in-place every 15 minutes. Without intervention, ImageKit's CDN would
         // serve the same cached copy for every request, making all 96 animation
@@ -89,60 +103,359 @@ String ImageDownloader::constructUrl(const String &timestamp)
         // The dash is stripped ("20260421-1200" → "202604211200") because some URL
         // parsers treat a bare dash as a separator and may truncate the value,
         // which would make all slots within the same day share the same bust value.
-    {
-        // Crop out EUMETSAT's border/label area before resizing to the display
-        // dimensions. METEOSAT_CROP_SIZE defines the intermediate square extracted
-        // from the centre of the full image; ImageKit then scales it down to
-        // DISPLAY_WIDTH × DISPLAY_HEIGHT. Adjust METEOSAT_CROP_SIZE in config.h
-        // to tighten or loosen the crop without changing any other settings.
-        String meteosatResize = "tr:w-" + String(METEOSAT_CROP_SIZE) +
-                                ",h-" + String(METEOSAT_CROP_SIZE) +
-                                ",cm-extract:w-" + String(DISPLAY_WIDTH) +
-                                ",h-" + String(DISPLAY_HEIGHT) +
-                                ",q-" + String(JPEG_QUALITY) + "/";
-        String bust = timestamp;
-        bust.replace("-", "");
-        const char* imageFile = (SATTYPE == METEOSAT_IODC)
-            ? METEOSAT_IODC_IMAGE_FILE
-            : METEOSAT_IMAGE_FILE;
-        const char* resizeUrl = (SATTYPE == METEOSAT_IODC)
-            ? RESIZEURL_METEOSAT_IODC
-            : RESIZEURL_METEOSAT;
-        return String(IMAGEKIT_ENDPOINT) + resizeUrl + meteosatResize +
-               imageFile + "?ik-cache-bust=" + bust;
-    }
-    default:
-        return "";
+        char bust[16];
+        size_t n = 0;
+        for (const char *c = timestamp; *c && n < sizeof(bust) - 1; c++)
+        {
+            if (*c != '-')
+                bust[n++] = *c;
+        }
+        bust[n] = '\0';
+        int written = snprintf(out, len, "%s%s", prefix, bust);
+        return written > 0 && (size_t)written < len;
     }
+
+    int written = snprintf(out, len, "%s%s%s", prefix, timestamp, _urlSuffix);
+    return written > 0 && (size_t)written < len;
+}
+
+bool ImageDownloader::isLatestOnlySource()
+{
+    return SATTYPE == METEOSAT || SATTYPE == METEOSAT_IODC;
+}
+
+static String validatorsPath()
+{
+    return "/meta/" + String(SATTYPE_NAME) + ".http";
+}
+
+void ImageDownloader::loadValidators()
+{
+    validatorsLoaded = true;
+    File file = LittleFS.open(validatorsPath(), "r");
+    if (!file)
+        return;
+    etag = file.readStringUntil('\n');
+    lastModified = file.readStringUntil('\n');
+    file.close();
+}
+
+// Only rewrite the file when a validator actually changed — a 200 carrying the
+// same ETag (server ignored If-None-Match) should not cost a flash write.
+void ImageDownloader::saveValidators(const String &newEtag, const String &newLastModified)
+{
+    if (newEtag == etag && newLastModified == lastModified)
+        return;
+    etag = newEtag;
+    lastModified = newLastModified;
+
+    File file = LittleFS.open(validatorsPath(), "w", true);
+    if (!file)
+        return;
+    file.print(etag + "\n" + lastModified + "\n");
+    file.close();
 }
 
 // ── Public methods ────────────────────────────────────────────────────────────
 
-// Fetch the image for the given timestamp.
-// Cache hit: loads the JPEG from LittleFS into imageBuffer — no network call.
-// Cache miss: opens an HTTP connection, downloads the JPEG into imageBuffer,
-//             then writes the result to LittleFS for future cache hits.
-bool ImageDownloader::downloadImage(const String &timestamp)
+// Make sure the given timestamp is in the cache.
+// Cache hit: nothing to do — no network call, no flash read.
+// Negative-cache hit: the slot failed recently and its backoff has not expired,
+//             so return false without touching the network.
+// Cache miss: fetches the JPEG at full quality into downloadBuffer, from a
+//             LAN peer if one has it and from ImageKit otherwise, then
+//             queues it for LittleFS. Failures are recorded in missCache
+//             with the HTTP status.
+bool ImageDownloader::downloadImage(const char *timestamp)
 {
-    if (cache.loadImage(timestamp))
+    if (cache.contains(timestamp))
     {
         if (DEBUG_ENABLED)
             Serial.print("Cache! ");
         return true;
     }
 
-    String url = constructUrl(timestamp);
+    if (missCache.shouldSkip(timestamp))
+    {
+        if (DEBUG_ENABLED)
+            Serial.print("Backoff! ");
+        return false;
+    }
+
+    int httpCode = fetchFromPeer(timestamp, 0) ? HTTP_CODE_OK : fetchFrame(timestamp, 0);
+    if (httpCode != HTTP_CODE_OK)
+    {
+        // Running out of RAM says nothing about the slot itself.
+        if (httpCode != HTTPC_ERROR_TOO_LESS_RAM)
+            missCache.recordFailure(timestamp, httpCode);
+        return false;
+    }
+    return storeDownload(timestamp);
+}
+
+// Queue the full-quality frame in downloadBuffer for the cache, unless it
+// repeats one already cached.
+bool ImageDownloader::storeDownload(const char *timestamp)
+{
+    // A server that ignores the validators still returns identical bytes when
+    // the source has not moved on. Treat that the same as a 304: nothing new
+    // to store or show for this slot yet.
+    uint32_t hash = ImageCache::contentHash(downloadBuffer, downloadSize);
+    if (cache.hasFrameWithHash(hash))
+    {
+        if (DEBUG_ENABLED)
+            Serial.println("Duplicate payload, not cached");
+        missCache.recordFailure(timestamp, HTTP_CODE_NOT_MODIFIED);
+        return false;
+    }
+
+    missCache.recordSuccess(timestamp);
+    cache.cacheImage(timestamp, downloadBuffer, downloadSize, hash, 0);
+    if (DEBUG_ENABLED)
+        Serial.println("Download complete");
+    return true;
+}
+
+// ── Transfer ──────────────────────────────────────────────────────────────────
+
+// Fetch the slot at the given tier's quality into downloadBuffer /
+// downloadSize. A body that stalls mid-transfer is not thrown away: the
+// bytes received are kept and the rest is requested with a Range, at once
+// (up to DOWNLOAD_RESUME_ATTEMPTS times while each attempt makes progress)
+// and, failing that, on a later pass from the copy saved on flash.
+int ImageDownloader::fetchFrame(const char *timestamp, uint8_t tier)
+{
+    char url[URL_MAX_LEN];
+    if (!constructUrl(timestamp, tier, url, sizeof(url)))
+    {
+        if (DEBUG_ENABLED)
+            Serial.println("URL too long, raise URL_MAX_LEN");
+        return HTTPC_ERROR_TOO_LESS_RAM;
+    }
     if (DEBUG_ENABLED)
     {
         Serial.print("URL: ");
         Serial.println(url);
     }
 
+    size_t have = loadPartial(timestamp, tier);
+    size_t saved = have;
+    if (have > 0)
+        metrics.recordDownloadRetry();
+
+    int httpCode;
+    for (int attempt = 0;; attempt++)
+    {
+        size_t before = have;
+        httpCode = transfer(url, have);
+
+        // The server refused the range or answered for different bytes: the
+        // saved part is useless, so drop it now, whatever the refetch brings,
+        // and fetch the whole frame instead.
+        if (httpCode == HTTP_CODE_RANGE_NOT_SATISFIABLE && before > 0)
+        {
+            metrics.recordDownloadWaste(before);
+            if (saved > 0)
+                dropPartial();
+            have = 0;
+            saved = 0;
+            continue;
+        }
+        if (httpCode != HTTPC_ERROR_READ_TIMEOUT || have <= before || attempt >= DOWNLOAD_RESUME_ATTEMPTS)
+            break;
+        metrics.recordDownloadRetry();
+    }
+
+    if (httpCode == HTTP_CODE_OK && saved > 0)
+        dropPartial();
+    else if (have > saved && have >= DOWNLOAD_RESUME_MIN_BYTES)
+        savePartial(timestamp, tier, have);
+    else if (have > saved)
+        metrics.recordDownloadWaste(have - saved);
+    return httpCode;
+}
+
+// Peers are asked in discovery order. One that cannot be reached is dropped
+// until the next discovery; a 404 just means it lacks this frame. Peer
+// traffic is counted apart from the origin's, so /status shows how much of
+// the window came over the LAN.
+bool ImageDownloader::fetchFromPeer(const char *timestamp, uint8_t tier)
+{
+    if (!PEER_CACHE_ENABLED || isLatestOnlySource())
+        return false;
+    peerCache.refresh();
+
+    for (int i = 0; i < peerCache.count(); i++)
+    {
+        char url[URL_MAX_LEN];
+        snprintf(url, sizeof(url), "http://%s:%u/frame?sat=%s&ts=%s&w=%d&h=%d&q=%d",
+                 peerCache.address(i).toString().c_str(), peerCache.port(i), SATTYPE_NAME,
+                 timestamp, DISPLAY_WIDTH, DISPLAY_HEIGHT, TIER_QUALITY[tier]);
+
+        HTTPClient http;
+        http.begin(url);
+        http.useHTTP10(true);
+        http.setConnectTimeout(PEER_TIMEOUT_MS);
+        http.setTimeout(PEER_TIMEOUT_MS);
+        const char *headerKeys[] = {"X-Frame-Hash"};
+        http.collectHeaders(headerKeys, 1);
+
+        int httpCode = http.GET();
+        if (httpCode < 0)
+        {
+            if (DEBUG_ENABLED)
+                Serial.printf("Peer %s unreachable, dropped\n", peerCache.address(i).toString().c_str());
+            http.end();
+            peerCache.drop(i--);
+            continue;
+        }
+        int reported = http.getSize();
+        if (httpCode != HTTP_CODE_OK || reported <= 0 || !reserveDownloadBuffer(reported))
+        {
+            http.end();
+            metrics.recordPeerFetch(false, 0);
+            continue;
+        }
+
+        WiFiClient *stream = http.getStreamPtr();
+        size_t bytesRead = 0;
+        unsigned long lastActivity = millis();
+        while (bytesRead < (size_t)reported && millis() - lastActivity <= PEER_TIMEOUT_MS)
+        {
+            size_t available = min((size_t)stream->available(), (size_t)reported - bytesRead);
+            if (available)
+            {
+                bytesRead += stream->readBytes(downloadBuffer + bytesRead, available);
+                lastActivity = millis();
+            }
+            else if (!stream->connected())
+                break;
+            else
+                vTaskDelay(pdMS_TO_TICKS(1));
+        }
+        String expected = http.header("X-Frame-Hash");
+        http.end();
+
+        // The peer verified the frame when it cached it; the hash proves it
+        // also arrived intact. Anything else goes to the next peer.
+        bool intact = bytesRead == (size_t)reported && bytesRead >= 4 &&
+                      downloadBuffer[0] == 0xFF && downloadBuffer[1] == 0xD8 &&
+                      downloadBuffer[bytesRead - 2] == 0xFF && downloadBuffer[bytesRead - 1] == 0xD9 &&
+                      (expected.isEmpty() ||
+                       strtoul(expected.c_str(), nullptr, 16) == ImageCache::contentHash(downloadBuffer, bytesRead));
+        if (!intact)
+        {
+            if (DEBUG_ENABLED)
+                Serial.println("Peer frame incomplete, discarded");
+            metrics.recordDownloadWaste(bytesRead);
+            metrics.recordPeerFetch(false, 0);
+            continue;
+        }
+
+        if (DEBUG_ENABLED)
+            Serial.printf("From peer %s: %u bytes\n", peerCache.address(i).toString().c_str(), (unsigned)bytesRead);
+        downloadSize = bytesRead;
+        metrics.recordPeerFetch(true, bytesRead);
+        return true;
+    }
+    return false;
+}
+
+// One HTTP request. With have > 0, downloadBuffer already holds the first
+// <have> bytes of a frame whose length and validator are in resumeTotal /
+// resumeValidator, and only the rest is requested. On return <have> is the
+// number of leading bytes of the frame held in downloadBuffer, so a stalled
+// body can be resumed from there.
+int ImageDownloader::transfer(const char *url, size_t &have)
+{
     HTTPClient http;
     http.begin(url);
+    // HTTP/1.0 rules out chunked transfer encoding, which getStreamPtr() would
+    // hand over raw (chunk-size lines and all). A server that does not know the
+    // length up front then simply closes the connection after the body.
+    http.useHTTP10(true);
+
+    // Meteosat: the bytes behind every URL are the same "latest" image, so ask
+    // the server to skip the body if it has not changed since the last download.
+    bool conditional = isLatestOnlySource();
+    if (conditional)
+    {
+        if (!validatorsLoaded)
+            loadValidators();
+        if (!etag.isEmpty())
+            http.addHeader("If-None-Match", etag);
+        if (!lastModified.isEmpty())
+            http.addHeader("If-Modified-Since", lastModified);
+    }
+
+    // Resume: ask for the missing tail only. If-Range makes the server send
+    // the whole frame with a 200 instead when its copy is no longer the one
+    // the saved bytes came from.
+    if (have > 0)
+    {
+        char range[24];
+        snprintf(range, sizeof(range), "bytes=%u-", (unsigned)have);
+        http.addHeader("Range", range);
+        http.addHeader("If-Range", resumeValidator);
+    }
+    const char *headerKeys[] = {"ETag", "Last-Modified", "Content-Range"};
+    http.collectHeaders(headerKeys, 3);
+
+    unsigned long requestStart = millis();
     int httpCode = http.GET();
+    uint32_t latencyMs = millis() - requestStart;
 
-    if (httpCode != HTTP_CODE_OK)
+    if (httpCode == HTTP_CODE_NOT_MODIFIED)
+    {
+        if (DEBUG_ENABLED)
+            Serial.println("Not modified");
+        http.end();
+        return httpCode;
+    }
+
+    // -1 when the server sends no Content-Length (a close-delimited body; see
+    // useHTTP10() above). The body is then read until the server hangs up.
+    int reported = http.getSize();
+
+    if (httpCode == HTTP_CODE_PARTIAL_CONTENT && have > 0)
+    {
+        // Content-Range: bytes <have>-<last>/<total>
+        unsigned long first = 0, last = 0, total = 0;
+        String range = http.header("Content-Range");
+        if (sscanf(range.c_str(), "bytes %lu-%lu/%lu", &first, &last, &total) != 3 ||
+            first != have || total != resumeTotal || reported <= 0)
+        {
+            if (DEBUG_ENABLED)
+                Serial.printf("Unusable Content-Range \"%s\"\n", range.c_str());
+            http.end();
+            return HTTP_CODE_RANGE_NOT_SATISFIABLE;
+        }
+        if (DEBUG_ENABLED)
+            Serial.printf("Resuming at %u of %u bytes\n", (unsigned)have, (unsigned)total);
+    }
+    else if (httpCode == HTTP_CODE_OK)
+    {
+        if (have > 0)
+        {
+            if (DEBUG_ENABLED)
+                Serial.println("Range not honoured, downloading in full");
+            metrics.recordDownloadWaste(have);
+            have = 0;
+        }
+
+        // Remember what a resume would need: the length, and a validator for
+        // If-Range. A weak ETag may not be used there, so fall back to
+        // Last-Modified; with neither, a stalled body cannot be resumed.
+        String validator = http.header("ETag");
+        if (validator.isEmpty() || validator.startsWith("W/"))
+            validator = http.header("Last-Modified");
+        resumeTotal = reported > 0 ? reported : 0;
+        if (conditional || validator.length() >= sizeof(resumeValidator))
+            resumeValidator[0] = '\0';
+        else
+            strlcpy(resumeValidator, validator.c_str(), sizeof(resumeValidator));
+    }
+    else
     {
         if (DEBUG_ENABLED)
         {
@@ -150,41 +463,53 @@ bool ImageDownloader::downloadImage(const String &timestamp)
             Serial.println(httpCode);
         }
         http.end();
-        return false;
+        metrics.recordDownloadFailure();
+        return httpCode;
     }
 
-    imageSize = http.getSize();
+    const size_t offset = have;
+    size_t imageSize = reported > 0 ? offset + reported : 0;
     if (DEBUG_ENABLED)
     {
         Serial.print("Image size: ");
-        Serial.println(imageSize);
+        Serial.println(reported);
     }
 
-    if (imageBuffer)
-        free(imageBuffer);
-    imageBuffer = (uint8_t *)malloc(imageSize);
-    if (!imageBuffer)
+    if (!reserveDownloadBuffer(reported > 0 ? imageSize : offset + DOWNLOAD_CHUNK_SIZE))
     {
         if (DEBUG_ENABLED)
             Serial.println("malloc failed");
         http.end();
-        return false;
+        metrics.recordDownloadFailure();
+        return HTTPC_ERROR_TOO_LESS_RAM;
     }
 
     // Read the stream in chunks, yielding to FreeRTOS between chunks so the
-    // task watchdog is not starved during slow downloads.
+    // task watchdog is not starved during slow downloads. A connection that
+    // closes early ends the read at once instead of waiting for the timeout.
     WiFiClient *stream = http.getStreamPtr();
-    size_t bytesRead = 0;
+    size_t bytesRead = offset;
     unsigned long lastActivity = millis();
+    bool closed = false;
 
-    while (bytesRead < imageSize)
+    while (reported <= 0 || bytesRead < imageSize)
     {
         size_t available = stream->available();
         if (available)
         {
-            bytesRead += stream->readBytes(imageBuffer + bytesRead, available);
+            if (reported > 0)
+                available = min(available, imageSize - bytesRead);
+            if (bytesRead + available > downloadCapacity &&
+                !reserveDownloadBuffer(bytesRead + max(available, (size_t)DOWNLOAD_CHUNK_SIZE)))
+                break;
+            bytesRead += stream->readBytes(downloadBuffer + bytesRead, available);
             lastActivity = millis();
         }
+        else if (!stream->connected())
+        {
+            closed = true;
+            break;
+        }
         else
         {
             if (millis() - lastActivity > DOWNLOAD_TIMEOUT_MS)
@@ -197,102 +522,453 @@ bool ImageDownloader::downloadImage(const String &timestamp)
         }
     }
 
+    // Without a Content-Length the only proof of a complete body is a clean
+    // close with the JPEG end-of-image marker in place.
+    if (reported <= 0)
+    {
+        bool eoi = bytesRead >= 2 &&
+                   downloadBuffer[bytesRead - 2] == 0xFF && downloadBuffer[bytesRead - 1] == 0xD9;
+        imageSize = closed && eoi ? bytesRead : bytesRead + 1;
+    }
+
+    uint32_t transferMs = millis() - requestStart - latencyMs;
+
+    String newEtag = conditional ? http.header("ETag") : String();
+    String newLastModified = conditional ? http.header("Last-Modified") : String();
     http.end();
 
     if (bytesRead != imageSize)
+    {
+        if (DEBUG_ENABLED)
+            Serial.printf("Incomplete body: %d bytes\n", bytesRead);
+        metrics.recordDownloadFailure();
+
+        // Keep the received head only if it can be resumed against: a known
+        // length and a validator for If-Range.
+        if (reported > 0 && resumeValidator[0])
+        {
+            have = bytesRead;
+        }
+        else
+        {
+            metrics.recordDownloadWaste(bytesRead);
+            have = 0;
+        }
+        return HTTPC_ERROR_READ_TIMEOUT;
+    }
+    metrics.recordDownload(bytesRead - offset, latencyMs, transferMs);
+    if (offset > 0)
+        metrics.recordDownloadResumed(offset);
+
+    if (conditional)
+        saveValidators(newEtag, newLastModified);
+
+    have = 0;
+    downloadSize = imageSize;
+    return HTTP_CODE_OK;
+}
+
+// ── Live frame ────────────────────────────────────────────────────────────────
+
+// Input side of a live frame: bytes come off the socket, are appended to the
+// cache file and folded into the content hash, then handed to the decoder.
+struct LiveTee
+{
+    WiFiClient *stream;
+    File *file;
+    size_t remaining;   // Body bytes not yet read
+    uint32_t crc;       // Running ImageCache::contentHash() of the body
+    unsigned long lastActivity;
+    bool writeFailed;
+};
+
+static uint8_t _liveScratch[512];              // Landing area for skipped bytes
+static unsigned long _firstPixelAt = 0;
+
+static size_t liveRead(void *ctx, uint8_t *buf, size_t len)
+{
+    LiveTee *t = (LiveTee *)ctx;
+    size_t n = 0;
+    while (n < len && t->remaining > 0)
+    {
+        size_t available = t->stream->available();
+        if (!available)
+        {
+            if (!t->stream->connected() || millis() - t->lastActivity > DOWNLOAD_TIMEOUT_MS)
+                break;
+            delay(1); // yield
+            continue;
+        }
+        uint8_t *dst = buf ? buf + n : _liveScratch;
+        size_t want = min(min(len - n, available), t->remaining);
+        if (!buf)
+            want = min(want, sizeof(_liveScratch));
+        size_t got = t->stream->readBytes(dst, want);
+        if (!t->writeFailed && t->file->write(dst, got) != got)
+            t->writeFailed = true;
+        t->crc = esp_rom_crc32_le(t->crc, dst, got);
+        t->remaining -= got;
+        t->lastActivity = millis();
+        n += got;
+    }
+    return n;
+}
+
+static void markFirstPixel(int16_t, int16_t, uint16_t, uint16_t, const uint16_t *)
+{
+    if (!_firstPixelAt)
+        _firstPixelAt = millis();
+}
+
+// Draw the newest frame straight off the socket instead of buffering it: the
+// first MCU rows appear once their bytes arrive rather than after the last
+// one, and no frame-sized buffer is allocated. The same bytes go to the cache
+// file as they pass. Only for a clean first attempt at an uncached slot with
+// a known length and room on flash; a retry takes the buffered path, which
+// can resume. A LAN peer that already has the slot is asked first, as
+// downloadImage() does, so the newest frame only comes from ImageKit when
+// no peer holds it. Returns false if the buffered path should handle the slot.
+bool ImageDownloader::streamLatest(const char *timestamp)
+{
+    if (isLatestOnlySource() || cache.contains(timestamp) || missCache.hasFailed(timestamp))
+        return false;
+    if (fetchFromPeer(timestamp, 0))
+    {
+        storeDownload(timestamp);
+        return true;
+    }
+    char url[URL_MAX_LEN];
+    if (!constructUrl(timestamp, 0, url, sizeof(url)))
         return false;
 
-    cache.cacheImage(timestamp);
+    HTTPClient http;
+    http.begin(url);
+    http.useHTTP10(true); // see transfer()
+
+    unsigned long requestStart = millis();
+    int httpCode = http.GET();
+    uint32_t latencyMs = millis() - requestStart;
+    int reported = http.getSize();
+
+    File file;
+    if (httpCode == HTTP_CODE_OK && reported > 0 && cache.hasRoomFor(reported))
+        file = cache.openStreamed(timestamp);
+    // Playback keeps animating while the request waits for headers; it only
+    // hands over the display once there is a body to draw.
+    if (file && !player.beginLiveFrame())
+    {
+        file.close();
+        cache.abortStreamed(timestamp);
+        http.end();
+        return false; // paused or scrubbing: don't draw over the user's frame
+    }
+    if (!file)
+    {
+        http.end();
+        if (httpCode == HTTP_CODE_OK)
+            return false; // no length or no room: buffer it instead
+        if (DEBUG_ENABLED)
+        {
+            Serial.print("HTTP error: ");
+            Serial.println(httpCode);
+        }
+        metrics.recordDownloadFailure();
+        missCache.recordFailure(timestamp, httpCode);
+        return true;
+    }
     if (DEBUG_ENABLED)
-        Serial.println("Download complete");
+        Serial.printf("Streaming %s (%d bytes)\n", timestamp, reported);
+
+    LiveTee tee = {http.getStreamPtr(), &file, (size_t)reported, 0, millis(), false};
+    lockDisplay();
+    _firstPixelAt = 0;
+    setTileTap(markFirstPixel);
+    bool drawn = drawJpegStream(0, 0, liveRead, &tee);
+    setTileTap(nullptr);
+    takeBlitMicros();
+    takeBlitTiles();
+    unlockDisplay();
+
+    // tjpgd stops after the last MCU; the end-of-image marker still has to
+    // reach the file.
+    while (tee.remaining > 0 && liveRead(&tee, nullptr, tee.remaining) > 0)
+    {
+    }
+    file.close();
+    http.end();
+
+    const size_t size = reported - tee.remaining;
+    const uint32_t totalMs = millis() - requestStart;
+    const bool complete = drawn && tee.remaining == 0 && !tee.writeFailed;
+
+    if (!complete)
+    {
+        if (DEBUG_ENABLED)
+            Serial.printf("Live frame failed after %d bytes\n", size);
+        cache.abortStreamed(timestamp);
+        metrics.recordDownloadFailure();
+        metrics.recordDownloadWaste(size);
+        missCache.recordFailure(timestamp, HTTPC_ERROR_READ_TIMEOUT);
+        player.endLiveFrame(timestamp, 0, false);
+        return true;
+    }
+
+    metrics.recordDownload(size, latencyMs, totalMs - latencyMs);
+    metrics.recordLiveFrame(_firstPixelAt ? _firstPixelAt - requestStart : totalMs, totalMs);
+    player.endLiveFrame(timestamp, tee.crc, true);
+
+    // Same rule as downloadImage(): identical bytes under a new slot are not
+    // stored twice. The picture on screen is the same either way.
+    if (cache.hasFrameWithHash(tee.crc))
+    {
+        if (DEBUG_ENABLED)
+            Serial.println("Duplicate payload, not cached");
+        cache.abortStreamed(timestamp);
+        missCache.recordFailure(timestamp, HTTP_CODE_NOT_MODIFIED);
+        return true;
+    }
+    if (cache.commitStreamed(timestamp, size, tee.crc))
+        missCache.recordSuccess(timestamp);
+    if (DEBUG_ENABLED)
+        Serial.printf("Live frame: first pixel %lu ms, complete %lu ms\n",
+                      (unsigned long)(_firstPixelAt ? _firstPixelAt - requestStart : totalMs),
+                      (unsigned long)totalMs);
     return true;
 }
 
-// Return the timestamp string for the most recent available satellite image.
-// Subtracts SERVER_LAG_MINUTES from the current UTC time to compensate for the
-// delay between image capture and CDN availability, then snaps to the cadence.
-String ImageDownloader::getFormattedTime()
+// ── Partial downloads ─────────────────────────────────────────────────────────
+
+// /meta/<satellite>.part holds at most one stalled body: this header followed
+// by its first <have> bytes. The sync task fetches one frame at a time, so a
+// single slot covers the common case of one large frame failing repeatedly,
+// at a bounded cost in flash.
+struct PartialHeader
+{
+    char     magic[4];      // "PRT1"
+    char     timestamp[16];
+    uint8_t  tier;
+    uint32_t total;
+    uint32_t have;
+    char     validator[80];
+};
+
+static const char PARTIAL_MAGIC[4] = {'P', 'R', 'T', '1'};
+
+static String partialPath()
+{
+    return "/meta/" + String(SATTYPE_NAME) + ".part";
+}
+
+// Read the header once at first use; afterwards partialTimestamp mirrors the
+// file, so a download with nothing to resume costs no flash access.
+size_t ImageDownloader::loadPartial(const char *timestamp, uint8_t tier)
 {
-    struct tm timeinfo;
-    if (!getLocalTime(&timeinfo))
+    if (!partialChecked)
     {
-        if (DEBUG_ENABLED)
-            Serial.println("Failed to get time");
-        return "";
+        partialChecked = true;
+        PartialHeader h;
+        File file = LittleFS.exists(partialPath()) ? LittleFS.open(partialPath(), "r") : File();
+        if (file && file.read((uint8_t *)&h, sizeof(h)) == sizeof(h) &&
+            memcmp(h.magic, PARTIAL_MAGIC, sizeof(h.magic)) == 0)
+        {
+            strlcpy(partialTimestamp, h.timestamp, sizeof(partialTimestamp));
+            partialTier = h.tier;
+        }
+        if (file)
+            file.close();
     }
-    timeinfo.tm_min -= SERVER_LAG_MINUTES;
-    mktime(&timeinfo); // normalise (handles minute underflow across hour boundaries)
+    if (strcmp(partialTimestamp, timestamp) != 0 || partialTier != tier)
+        return 0;
 
-    if (DEBUG_ENABLED)
+    PartialHeader h;
+    File file = LittleFS.open(partialPath(), "r");
+    if (!file)
+        return 0;
+    bool ok = file.read((uint8_t *)&h, sizeof(h)) == sizeof(h) &&
+              h.have > 0 && h.have < h.total && h.validator[0] &&
+              reserveDownloadBuffer(h.total) &&
+              file.read(downloadBuffer, h.have) == h.have;
+    file.close();
+    if (!ok)
     {
-        Serial.printf("Time: %02d:%02d, Day: %d\n",
-                      timeinfo.tm_hour, timeinfo.tm_min, timeinfo.tm_yday + 1);
+        dropPartial();
+        return 0;
     }
-    return formatTimestamp(timeinfo);
+
+    resumeTotal = h.total;
+    strlcpy(resumeValidator, h.validator, sizeof(resumeValidator));
+    if (DEBUG_ENABLED)
+        Serial.printf("Saved partial: %u of %u bytes\n", (unsigned)h.have, (unsigned)h.total);
+    return h.have;
 }
 
-// Iterate forward through all NROFIMAGESTOSHOW frames of the 24-hour window,
-// downloading and immediately drawing each one. The window starts at
-// (now − SERVER_LAG_MINUTES − (NROFIMAGESTOSHOW−1) × step) so that the last
-// frame shown is always the most recently available image.
-void ImageDownloader::showLastXHours()
+// Replaces whatever partial was saved before, so an older stalled frame
+// gives way to the newest one.
+void ImageDownloader::savePartial(const char *timestamp, uint8_t tier, size_t have)
 {
-    struct tm timeinfo;
-    if (!getLocalTime(&timeinfo))
+    PartialHeader h = {};
+    memcpy(h.magic, PARTIAL_MAGIC, sizeof(h.magic));
+    strlcpy(h.timestamp, timestamp, sizeof(h.timestamp));
+    h.tier = tier;
+    h.total = resumeTotal;
+    h.have = have;
+    strlcpy(h.validator, resumeValidator, sizeof(h.validator));
+
+    File file = LittleFS.open(partialPath(), "w", true);
+    bool ok = file &&
+              file.write((const uint8_t *)&h, sizeof(h)) == sizeof(h) &&
+              file.write(downloadBuffer, have) == have;
+    if (file)
+        file.close();
+    if (!ok)
     {
-        if (DEBUG_ENABLED)
-            Serial.println("Failed to get time");
+        LittleFS.remove(partialPath());
+        partialTimestamp[0] = '\0';
+        metrics.recordDownloadWaste(have);
         return;
     }
+    strlcpy(partialTimestamp, timestamp, sizeof(partialTimestamp));
+    partialTier = tier;
+    if (DEBUG_ENABLED)
+        Serial.printf("Saved %u of %u bytes for resume\n", (unsigned)have, (unsigned)resumeTotal);
+}
 
-    // Apply the same server-lag correction used in getFormattedTime().
-    timeinfo.tm_min -= SERVER_LAG_MINUTES;
+void ImageDownloader::dropPartial()
+{
+    if (!partialTimestamp[0])
+        return;
+    LittleFS.remove(partialPath());
+    partialTimestamp[0] = '\0';
+}
 
-    // Rewind to the start of the animation window.
-    int stepMinutes;
-    switch (SATTYPE)
+// Grow-only: once the largest frame has been seen, downloads stop allocating.
+bool ImageDownloader::reserveDownloadBuffer(size_t bytes)
+{
+    if (bytes <= downloadCapacity)
+        return true;
+    uint8_t *grown = (uint8_t *)realloc(downloadBuffer, bytes);
+    if (!grown)
+        return false;
+    downloadBuffer = grown;
+    downloadCapacity = bytes;
+    return true;
+}
+
+// Start the sync task. Its stack must fit HTTPClient plus TLS; see config.h.
+void ImageDownloader::startSync()
+{
+    xTaskCreatePinnedToCore(syncTask, "sync", SYNC_TASK_STACK, nullptr,
+                            SYNC_TASK_PRIORITY, nullptr, SYNC_TASK_CORE);
+}
+
+// ── Background sync ───────────────────────────────────────────────────────────
+
+void ImageDownloader::syncTask(void *arg)
+{
+    Timeline timeline;
+    for (;;)
     {
-    case ELEKTROL:
-        stepMinutes = 30;
-        break;
-    case METEOSAT:
-    case METEOSAT_IODC:
-        stepMinutes = 60; // low-res image updates every 60 min
-        break;
-    case GOES_EAST:
-    case GOES_WEST:
-    default:
-        stepMinutes = 10;
-        break;
+        syncOnce(timeline);
+        vTaskDelay(pdMS_TO_TICKS(UPDATE_INTERVAL_MS));
     }
-    timeinfo.tm_min -= (NROFIMAGESTOSHOW - 1) * stepMinutes;
-    mktime(&timeinfo);
+}
 
-    for (int i = 0; i < NROFIMAGESTOSHOW; i++)
-    {
-        String ts = formatTimestamp(timeinfo);
+// Shrink old history instead of losing it: once LittleFS passes
+// CACHE_AGED_FILL_THRESHOLD, re-fetch full-quality frames older than
+// CACHE_AGED_AFTER_MIN at CACHE_AGED_QUALITY, oldest first. The replacement
+// goes through the normal write queue, so the old copy stays playable until
+// the new one is on flash. Failures are not recorded in missCache: the slot
+// is still cached, and the next pass simply tries again. Attempts, not
+// successes, count against CACHE_AGED_PER_PASS, and a network error ends the
+// pass, so a server that is down or rejects the aged quality cannot hold up
+// the backfill of new frames.
+void ImageDownloader::demoteAgedFrames(Timeline &timeline)
+{
+    int demoted = 0;
+    int attempts = 0;
 
-        // Meteosat: only play back what is already cached — downloading on a cache
-        // miss would fetch "latest" into a historical slot, which is wrong.
-        bool loaded = (SATTYPE == METEOSAT || SATTYPE == METEOSAT_IODC)
-                          ? cache.loadImage(ts)
-                          : downloadImage(ts);
-        if (loaded)
+    for (int i = 0; i < timeline.count() - 1 && attempts < CACHE_AGED_PER_PASS; i++)
+    {
+        if (timeline.ageMinutes(i) < CACHE_AGED_AFTER_MIN)
+            break; // slots are oldest first
+        if (LittleFS.usedBytes() < LittleFS.totalBytes() * CACHE_AGED_FILL_THRESHOLD)
+            break;
+        const char *ts = timeline.timestamp(i);
+        if (cache.frameTier(ts) != 0)
+            continue; // not cached, or already aged
+        attempts++;
+        if (!fetchFromPeer(ts, 1))
         {
-            if (DEBUG_ENABLED)
-                Serial.printf("Frame %d/%d: %s  Size: %d byte\n",
-                              i + 1, NROFIMAGESTOSHOW, ts.c_str(), imageSize);
-            TJpgDec.drawJpg(0, 0, imageBuffer, imageSize);
-            delay(FRAME_DELAY_MS);
+            int httpCode = fetchFrame(ts, 1);
+            if (httpCode < 0 && httpCode != HTTPC_ERROR_TOO_LESS_RAM)
+                break; // unreachable: the rest would only time out too
+            if (httpCode != HTTP_CODE_OK)
+                continue;
         }
-        else
+        cache.cacheImage(ts, downloadBuffer, downloadSize,
+                         ImageCache::contentHash(downloadBuffer, downloadSize), 1);
+        demoted++;
+    }
+
+    if (DEBUG_ENABLED && demoted > 0)
+        Serial.printf("Aged %d frame(s) to q-%d\n", demoted, CACHE_AGED_QUALITY);
+}
+
+// One pass over the window. The newest slot is fetched first so a fresh image
+// reaches the screen as soon as possible; the rest of the window is backfilled
+// afterwards, coarse to fine, so after a reset or satellite switch playback
+// spans the whole window within a few downloads (see Timeline::backfillOrder()).
+void ImageDownloader::syncOnce(Timeline &timeline)
+{
+    // Reconnect quietly: setupWiFi() draws over playback and blocks for the
+    // whole connect timeout. The next pass finds out whether it worked.
+    if (WiFi.status() != WL_CONNECTED)
+    {
+        reconnectWiFi();
+        return;
+    }
+    startNetworkServices(); // in case boot came up without WiFi
+
+    timeline.refresh();
+    const int n = timeline.count();
+    if (n == 0)
+    {
+        if (DEBUG_ENABLED)
+            Serial.println("Failed to get time");
+        return;
+    }
+
+    // Slots older than the window start will never be requested again, and
+    // frames that fell out of the window (or into a sparse-zone gap) are
+    // deleted before anything new is downloaded.
+    missCache.prune(timeline.timestamp(0));
+    cache.pruneOutsideWindow(timeline);
+
+    const char *latest = timeline.timestamp(n - 1);
+    if (DEBUG_ENABLED)
+        Serial.printf("Sync: latest slot %s\n", latest);
+    if (!(STREAM_LATEST_FRAME && streamLatest(latest)))
+        downloadImage(latest);
+
+    // Meteosat: only the newest slot can be fetched — downloading on a cache
+    // miss would store "latest" into a historical slot, which is wrong.
+    if (!isLatestOnlySource())
+    {
+        static int order[NROFIMAGESTOSHOW]; // sync task only
+        const int count = timeline.backfillOrder(order);
+        for (int k = 0; k < count; k++)
         {
-            if (DEBUG_ENABLED)
-                Serial.printf("Frame %d/%d: %s  MISS\n",
-                              i + 1, NROFIMAGESTOSHOW, ts.c_str());
+            downloadImage(timeline.timestamp(order[k]));
         }
-
-        timeinfo.tm_min += stepMinutes;
-        mktime(&timeinfo);
     }
+
+    if (!isLatestOnlySource())
+        demoteAgedFrames(timeline);
+
+    // Persist backoff state and the frame index once per pass rather than
+    // after every frame, then report cache health so the user can see how
+    // full the cache is and whether quality settings need tuning.
+    missCache.save();
+    cache.saveIndex();
+    cache.printStats();
 }
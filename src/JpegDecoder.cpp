@@ -0,0 +1,168 @@
+// JpegDecoder.cpp — pluggable JPEG decoder backends.
+
+#include "JpegDecoder.h"
+#include "config.h"
+#include "Display.h"
+#include <TJpg_Decoder.h>
+#ifdef JPEG_DECODER_JPEGDEC
+#include <JPEGDEC.h>
+#include <esp_heap_caps.h>
+#include <new>
+#endif
+
+// ── TJpgDec ───────────────────────────────────────────────────────────────────
+
+class TJpgBackend : public JpegDecoder {
+public:
+    const char *name() const override { return "TJpgDec"; }
+
+    // setSwapBytes(false) because Arduino_GFX expects native-endian
+    // (little-endian) RGB565.
+    bool begin() override {
+        TJpgDec.setSwapBytes(false);
+        TJpgDec.setCallback(tft_output);
+        return true;
+    }
+
+    bool getSize(const uint8_t *data, size_t size, uint16_t *w, uint16_t *h) override {
+        return TJpgDec.getJpgSize(w, h, data, size) == JDR_OK;
+    }
+
+    bool draw(int16_t x, int16_t y, const uint8_t *data, size_t size) override {
+        return TJpgDec.drawJpg(x, y, data, size) == JDR_OK;
+    }
+
+    // The tjpgd work area lives inside the global TJpgDec object.
+    size_t stateBytes() const override { return sizeof(TJpg_Decoder); }
+};
+
+static TJpgBackend _tjpg;
+
+// ── JPEGDEC ───────────────────────────────────────────────────────────────────
+
+#ifdef JPEG_DECODER_JPEGDEC
+
+// JPEGDEC hands over whole MCU rows at the MCU-rounded width, with the pixels
+// past the right edge of the image as padding. Drop the padding in place so
+// tft_output() receives a tightly packed block, as it does from TJpgDec.
+static int jpegdecDraw(JPEGDRAW *block) {
+    uint16_t *pixels = block->pPixels;
+    int       w      = block->iWidthUsed;
+    if (w < block->iWidth) {
+        for (int row = 1; row < block->iHeight; row++)
+            memmove(pixels + row * w, pixels + row * block->iWidth, w * sizeof(uint16_t));
+    }
+    return tft_output(block->x, block->y, w, block->iHeight, pixels) ? 1 : 0;
+}
+
+class JpegDecBackend : public JpegDecoder {
+public:
+    const char *name() const override { return "JPEGDEC"; }
+
+    // The JPEGDEC object carries its Huffman tables and MCU buffers (~18 KB).
+    // Keep it in internal RAM: a plain new of that size may land in PSRAM,
+    // which would cost more than the SIMD saves.
+    bool begin() override {
+        if (jpeg) return true;
+        void *mem = heap_caps_malloc(sizeof(JPEGDEC), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+        if (!mem) return false;
+        jpeg = new (mem) JPEGDEC();
+        return true;
+    }
+
+    bool getSize(const uint8_t *data, size_t size, uint16_t *w, uint16_t *h) override {
+        if (!jpeg || !jpeg->openRAM((uint8_t *)data, size, jpegdecDraw)) return false;
+        *w = jpeg->getWidth();
+        *h = jpeg->getHeight();
+        jpeg->close();
+        return true;
+    }
+
+    bool draw(int16_t x, int16_t y, const uint8_t *data, size_t size) override {
+        if (!jpeg || !jpeg->openRAM((uint8_t *)data, size, jpegdecDraw)) return false;
+        jpeg->setPixelType(RGB565_LITTLE_ENDIAN);
+        bool ok = jpeg->decode(x, y, 0) == 1;
+        jpeg->close();
+        return ok;
+    }
+
+    size_t stateBytes() const override { return sizeof(JPEGDEC); }
+
+private:
+    JPEGDEC *jpeg = nullptr;
+};
+
+static JpegDecBackend _jpegdec;
+
+// The active decoder: JPEGDEC, or TJpgDec if JPEGDEC cannot get its internal
+// RAM at begin(). name() reports whichever is in use.
+class FallbackDecoder : public JpegDecoder {
+public:
+    const char *name() const override { return active->name(); }
+
+    bool begin() override {
+        active = &_jpegdec;
+        if (_jpegdec.begin()) return true;
+        if (DEBUG_ENABLED) Serial.println("JPEGDEC: no internal RAM, falling back to TJpgDec");
+        active = &_tjpg;
+        return _tjpg.begin();
+    }
+
+    bool getSize(const uint8_t *data, size_t size, uint16_t *w, uint16_t *h) override {
+        return active->getSize(data, size, w, h);
+    }
+
+    bool draw(int16_t x, int16_t y, const uint8_t *data, size_t size) override {
+        return active->draw(x, y, data, size);
+    }
+
+    size_t stateBytes() const override { return active->stateBytes(); }
+
+private:
+    JpegDecoder *active = &_jpegdec;
+};
+
+static FallbackDecoder _active;
+JpegDecoder &jpegDecoder = _active;
+
+#else
+JpegDecoder &jpegDecoder = _tjpg;
+#endif
+
+// ── Streaming (tjpgd) ─────────────────────────────────────────────────────────
+
+struct JpegStream {
+    JpegReadFn read;
+    void      *ctx;
+    int16_t    x, y;
+};
+
+static size_t streamInput(JDEC *jd, uint8_t *buf, size_t len) {
+    JpegStream *s = (JpegStream *)jd->device;
+    return s->read(s->ctx, buf, len);
+}
+
+static int streamOutput(JDEC *jd, void *bitmap, JRECT *rect) {
+    JpegStream *s = (JpegStream *)jd->device;
+    return tft_output(s->x + rect->left, s->y + rect->top,
+                      rect->right - rect->left + 1, rect->bottom - rect->top + 1,
+                      (uint16_t *)bitmap) ? 1 : 0;
+}
+
+// Only the sync task streams, so one static work area suffices.
+static uint8_t _streamWork[TJPGD_WORKSPACE_SIZE];
+
+bool drawJpegStream(int16_t x, int16_t y, JpegReadFn read, void *ctx) {
+    JpegStream s = {read, ctx, x, y};
+    JDEC       jd;
+    if (jd_prepare(&jd, streamInput, _streamWork, sizeof(_streamWork), &s) != JDR_OK) return false;
+    return jd_decomp(&jd, streamOutput, 0) == JDR_OK;
+}
+
+JpegDecoder *jpegBackend(int i) {
+    if (i == 0) return &_tjpg;
+#ifdef JPEG_DECODER_JPEGDEC
+    if (i == 1) return &_jpegdec;
+#endif
+    return nullptr;
+}
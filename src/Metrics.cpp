@@ -0,0 +1,381 @@
+// Metrics.cpp — runtime counters and the on-device HTTP metrics endpoint.
+
+#include "Metrics.h"
+#include "config.h"
+#include "ImageCache.h"
+#include "PeerCache.h"
+#include <WiFi.h>
+#include <WebServer.h>
+#include <esp_heap_caps.h>
+
+// Single global instance shared by every module that records events.
+Metrics metrics;
+
+static WebServer _server(METRICS_PORT);
+
+// One response is rendered at a time (the server task is single-threaded),
+// so a static buffer avoids building the body out of String fragments.
+static char _body[METRICS_BODY_SIZE];
+
+// ── Recording ─────────────────────────────────────────────────────────────────
+
+void Metrics::recordDownload(size_t bytes, uint32_t latencyMs, uint32_t transferMs) {
+    downloads++;
+    downloadBytes   += bytes;
+    downloadMsTotal += latencyMs + transferMs;
+    lastLatencyMs    = latencyMs;
+    lastThroughputBps = transferMs > 0 ? (uint32_t)((uint64_t)bytes * 1000 / transferMs) : 0;
+}
+
+void Metrics::recordDownloadFailure() {
+    downloadFailures++;
+}
+
+void Metrics::recordDownloadRetry() {
+    downloadRetries++;
+}
+
+void Metrics::recordDownloadWaste(size_t bytes) {
+    wastedBytes += bytes;
+}
+
+void Metrics::recordDownloadResumed(size_t bytes) {
+    resumedBytes += bytes;
+}
+
+void Metrics::recordCacheWrite(size_t bytes) {
+    cacheWrites++;
+    cacheWriteBytes += bytes;
+}
+
+void Metrics::recordEviction() {
+    evictions++;
+}
+
+void Metrics::recordDemotion(size_t bytesSaved) {
+    demotions++;
+    demotionBytesSaved += bytesSaved;
+}
+
+void Metrics::recordLiveFrame(uint32_t firstPixelMs, uint32_t totalMs) {
+    liveFrames++;
+    lastFirstPixelMs = firstPixelMs;
+    lastLiveTotalMs  = totalMs;
+}
+
+void Metrics::recordPrefetch(bool hit) {
+    if (hit) prefetchHits++;
+    else     prefetchMisses++;
+}
+
+void Metrics::setPrefetchDepth(int depth) {
+    prefetchDepth = depth;
+}
+
+void Metrics::recordPeerFetch(bool hit, size_t bytes) {
+    if (hit) peerHits++;
+    else     peerMisses++;
+    peerBytes += bytes;
+}
+
+void Metrics::recordPeerServed(size_t bytes) {
+    peerServed++;
+    peerServedBytes += bytes;
+}
+
+void Metrics::setPeerCount(int count) {
+    peerCount = count;
+}
+
+void Metrics::bootPhase(const char *name) {
+    uint32_t now = millis();
+    if (bootPhaseCount < METRICS_BOOT_PHASES)
+        bootPhases[bootPhaseCount++] = {name, now - bootMarkMs};
+    bootMarkMs = now;
+}
+
+void Metrics::printBootReport() {
+    if (!DEBUG_ENABLED) return;
+    Serial.println(F("Boot phases:"));
+    for (int i = 0; i < bootPhaseCount; i++)
+        Serial.printf("  %-14s %6lu ms\n", bootPhases[i].name, (unsigned long)bootPhases[i].ms);
+    Serial.printf("  %-14s %6lu ms\n", "total", (unsigned long)bootMarkMs);
+}
+
+// FPS is an exponential moving average of the frame interval. Gaps longer than
+// METRICS_FPS_GAP_MS (paused, scrubbing, holding on the newest frame) are left
+// out so the figure reflects the rate actually achieved while animating.
+void Metrics::recordFrame(uint32_t decodeUs, uint32_t blitUs, bool rle, size_t bytes, uint32_t tiles) {
+    FormatStats& f = formats[rle ? 1 : 0];
+    f.frames++;
+    f.decodeUs += decodeUs;
+    f.blitUs   += blitUs;
+    f.bytes    += bytes;
+    f.tiles    += tiles;
+
+    framesDrawn++;
+    lastDecodeUs   = decodeUs;
+    lastBlitUs     = blitUs;
+    decodeUsTotal += decodeUs;
+    blitUsTotal   += blitUs;
+
+    uint32_t now      = millis();
+    uint32_t interval = now - lastFrameAt;
+    if (lastFrameAt != 0 && interval > 0 && interval <= METRICS_FPS_GAP_MS) {
+        float instant = 1000.0f / interval;
+        fps = fps == 0 ? instant : fps * 0.9f + instant * 0.1f;
+    }
+    lastFrameAt = now;
+}
+
+void Metrics::recordFrameFailure() {
+    frameFailures++;
+}
+
+// ── Rendering ─────────────────────────────────────────────────────────────────
+
+static const char *FORMAT_NAMES[2] = {"jpeg", "rle"};
+
+size_t Metrics::renderJson(char *buf, size_t len) {
+    int    frames = 0;
+    size_t bytes  = 0;
+    cache.indexStats(frames, bytes);
+
+    uint32_t avgDownloadMs = downloads   ? downloadMsTotal / downloads   : 0;
+    uint32_t avgDecodeUs   = framesDrawn ? decodeUsTotal   / framesDrawn : 0;
+    uint32_t avgBlitUs     = framesDrawn ? blitUsTotal     / framesDrawn : 0;
+
+    // Per-format averages; max_fps is the rate the draw path alone could
+    // sustain, i.e. the ceiling without FRAME_DELAY_MS pacing. blit_ns_per_tile
+    // is the output-path cost of one decoded block (see DISPLAY_DIRECT_BLIT).
+    char perFormat[400];
+    int  p = 0;
+    for (int i = 0; i < 2 && p < (int)sizeof(perFormat); i++) {
+        const FormatStats& f = formats[i];
+        uint32_t decode = f.frames ? f.decodeUs / f.frames : 0;
+        uint32_t blit   = f.frames ? f.blitUs   / f.frames : 0;
+        p += snprintf(perFormat + p, sizeof(perFormat) - p,
+                      "%s\"%s\":{\"frames\":%lu,\"avg_decode_us\":%lu,\"avg_blit_us\":%lu,"
+                      "\"avg_bytes\":%lu,\"avg_tiles\":%lu,\"blit_ns_per_tile\":%lu,\"max_fps\":%.1f}",
+                      i ? "," : "", FORMAT_NAMES[i], (unsigned long)f.frames,
+                      (unsigned long)decode, (unsigned long)blit,
+                      (unsigned long)(f.frames ? f.bytes / f.frames : 0),
+                      (unsigned long)(f.frames ? f.tiles / f.frames : 0),
+                      (unsigned long)(f.tiles ? (uint64_t)f.blitUs * 1000 / f.tiles : 0),
+                      decode + blit ? 1e6f / (decode + blit) : 0.0f);
+    }
+
+    // Boot phase durations, e.g. "wifi_ms":2140, to spot boot-time regressions.
+    char boot[320];
+    int  q = 0;
+    for (int i = 0; i < bootPhaseCount && q < (int)sizeof(boot); i++)
+        q += snprintf(boot + q, sizeof(boot) - q, "\"%s_ms\":%lu,",
+                      bootPhases[i].name, (unsigned long)bootPhases[i].ms);
+    if (q < (int)sizeof(boot))
+        snprintf(boot + q, sizeof(boot) - q, "\"total_ms\":%lu", (unsigned long)bootMarkMs);
+
+    int n = snprintf(buf, len,
+        "{\"device\":\"%s\",\"satellite\":\"%s\",\"uptime_s\":%lu,\"boot\":{%s},"
+        "\"cache\":{\"frames\":%d,\"bytes\":%u,\"writes\":%lu,\"write_bytes\":%lu,\"evictions\":%lu,"
+        "\"demotions\":%lu,\"demotion_bytes_saved\":%lu},"
+        "\"download\":{\"count\":%lu,\"failures\":%lu,\"bytes\":%lu,\"avg_ms\":%lu,"
+        "\"last_latency_ms\":%lu,\"last_throughput_bps\":%lu,"
+        "\"retries\":%lu,\"wasted_bytes\":%lu,\"resumed_bytes\":%lu},"
+        "\"playback\":{\"frames\":%lu,\"failures\":%lu,\"fps\":%.2f,\"last_decode_us\":%lu,\"last_blit_us\":%lu,"
+        "\"avg_decode_us\":%lu,\"avg_blit_us\":%lu,\"formats\":{%s}},"
+        "\"prefetch\":{\"depth\":%d,\"hits\":%lu,\"misses\":%lu,\"hit_rate\":%.3f},"
+        "\"live\":{\"frames\":%lu,\"last_first_pixel_ms\":%lu,\"last_total_ms\":%lu},"
+        "\"peers\":{\"known\":%d,\"hits\":%lu,\"misses\":%lu,\"bytes\":%lu,"
+        "\"served\":%lu,\"served_bytes\":%lu},"
+        "\"memory\":{\"heap_free\":%u,\"heap_largest_block\":%u,"
+        "\"psram_free\":%u,\"psram_largest_block\":%u},"
+        "\"wifi\":{\"rssi_dbm\":%d}}\n",
+        DEVICENAME, SATTYPE_NAME, (unsigned long)(millis() / 1000), boot,
+        frames, (unsigned)bytes, (unsigned long)cacheWrites, (unsigned long)cacheWriteBytes,
+        (unsigned long)evictions, (unsigned long)demotions, (unsigned long)demotionBytesSaved,
+        (unsigned long)downloads, (unsigned long)downloadFailures, (unsigned long)downloadBytes,
+        (unsigned long)avgDownloadMs, (unsigned long)lastLatencyMs, (unsigned long)lastThroughputBps,
+        (unsigned long)downloadRetries, (unsigned long)wastedBytes, (unsigned long)resumedBytes,
+        (unsigned long)framesDrawn, (unsigned long)frameFailures, fps, (unsigned long)lastDecodeUs, (unsigned long)lastBlitUs,
+        (unsigned long)avgDecodeUs, (unsigned long)avgBlitUs, perFormat,
+        prefetchDepth, (unsigned long)prefetchHits, (unsigned long)prefetchMisses,
+        prefetchHits + prefetchMisses ? (float)prefetchHits / (prefetchHits + prefetchMisses) : 0.0f,
+        (unsigned long)liveFrames, (unsigned long)lastFirstPixelMs, (unsigned long)lastLiveTotalMs,
+        peerCount, (unsigned long)peerHits, (unsigned long)peerMisses, (unsigned long)peerBytes,
+        (unsigned long)peerServed, (unsigned long)peerServedBytes,
+        (unsigned)heap_caps_get_free_size(MALLOC_CAP_INTERNAL),
+        (unsigned)heap_caps_get_largest_free_block(MALLOC_CAP_INTERNAL),
+        (unsigned)heap_caps_get_free_size(MALLOC_CAP_SPIRAM),
+        (unsigned)heap_caps_get_largest_free_block(MALLOC_CAP_SPIRAM),
+        (int)WiFi.RSSI());
+    return n < 0 ? 0 : min((size_t)n, len - 1);
+}
+
+// Prometheus text exposition format. Totals are exposed as counters (the
+// scraper derives rates); sums of microseconds are exposed alongside frame
+// counts so averages over any window can be computed server-side.
+size_t Metrics::renderPrometheus(char *buf, size_t len) {
+    int    frames = 0;
+    size_t bytes  = 0;
+    cache.indexStats(frames, bytes);
+
+    int n = snprintf(buf, len,
+        "# TYPE flatearth_uptime_seconds gauge\n"
+        "flatearth_uptime_seconds %lu\n"
+        "# TYPE flatearth_cache_frames gauge\n"
+        "flatearth_cache_frames{satellite=\"%s\"} %d\n"
+        "# TYPE flatearth_cache_bytes gauge\n"
+        "flatearth_cache_bytes{satellite=\"%s\"} %u\n"
+        "# TYPE flatearth_cache_writes_total counter\n"
+        "flatearth_cache_writes_total %lu\n"
+        "# TYPE flatearth_cache_write_bytes_total counter\n"
+        "flatearth_cache_write_bytes_total %lu\n"
+        "# TYPE flatearth_cache_evictions_total counter\n"
+        "flatearth_cache_evictions_total %lu\n"
+        "# TYPE flatearth_cache_demotions_total counter\n"
+        "flatearth_cache_demotions_total %lu\n"
+        "# TYPE flatearth_cache_demotion_bytes_saved_total counter\n"
+        "flatearth_cache_demotion_bytes_saved_total %lu\n"
+        "# TYPE flatearth_downloads_total counter\n"
+        "flatearth_downloads_total %lu\n"
+        "# TYPE flatearth_download_failures_total counter\n"
+        "flatearth_download_failures_total %lu\n"
+        "# TYPE flatearth_download_bytes_total counter\n"
+        "flatearth_download_bytes_total %lu\n"
+        "# TYPE flatearth_download_milliseconds_total counter\n"
+        "flatearth_download_milliseconds_total %lu\n"
+        "# TYPE flatearth_download_latency_milliseconds gauge\n"
+        "flatearth_download_latency_milliseconds %lu\n"
+        "# TYPE flatearth_download_throughput_bytes_per_second gauge\n"
+        "flatearth_download_throughput_bytes_per_second %lu\n"
+        "# TYPE flatearth_download_retries_total counter\n"
+        "flatearth_download_retries_total %lu\n"
+        "# TYPE flatearth_download_wasted_bytes_total counter\n"
+        "flatearth_download_wasted_bytes_total %lu\n"
+        "# TYPE flatearth_download_resumed_bytes_total counter\n"
+        "flatearth_download_resumed_bytes_total %lu\n"
+        "# TYPE flatearth_frames_drawn_total counter\n"
+        "flatearth_frames_drawn_total %lu\n"
+        "# TYPE flatearth_frame_failures_total counter\n"
+        "flatearth_frame_failures_total %lu\n"
+        "# TYPE flatearth_decode_microseconds_total counter\n"
+        "flatearth_decode_microseconds_total %lu\n"
+        "# TYPE flatearth_blit_microseconds_total counter\n"
+        "flatearth_blit_microseconds_total %lu\n"
+        "# TYPE flatearth_decode_microseconds gauge\n"
+        "flatearth_decode_microseconds %lu\n"
+        "# TYPE flatearth_blit_microseconds gauge\n"
+        "flatearth_blit_microseconds %lu\n"
+        "# TYPE flatearth_fps gauge\n"
+        "flatearth_fps %.2f\n"
+        "# TYPE flatearth_prefetch_hits_total counter\n"
+        "flatearth_prefetch_hits_total %lu\n"
+        "# TYPE flatearth_prefetch_misses_total counter\n"
+        "flatearth_prefetch_misses_total %lu\n"
+        "# TYPE flatearth_prefetch_depth gauge\n"
+        "flatearth_prefetch_depth %d\n"
+        "# TYPE flatearth_live_frames_total counter\n"
+        "flatearth_live_frames_total %lu\n"
+        "# TYPE flatearth_live_first_pixel_milliseconds gauge\n"
+        "flatearth_live_first_pixel_milliseconds %lu\n"
+        "# TYPE flatearth_peers gauge\n"
+        "flatearth_peers %d\n"
+        "# TYPE flatearth_peer_fetches_total counter\n"
+        "flatearth_peer_fetches_total{result=\"hit\"} %lu\n"
+        "flatearth_peer_fetches_total{result=\"miss\"} %lu\n"
+        "# TYPE flatearth_peer_bytes_total counter\n"
+        "flatearth_peer_bytes_total %lu\n"
+        "# TYPE flatearth_peer_served_total counter\n"
+        "flatearth_peer_served_total %lu\n"
+        "# TYPE flatearth_peer_served_bytes_total counter\n"
+        "flatearth_peer_served_bytes_total %lu\n"
+        "# TYPE flatearth_heap_free_bytes gauge\n"
+        "flatearth_heap_free_bytes{region=\"internal\"} %u\n"
+        "flatearth_heap_free_bytes{region=\"psram\"} %u\n"
+        "# TYPE flatearth_heap_largest_free_block_bytes gauge\n"
+        "flatearth_heap_largest_free_block_bytes{region=\"internal\"} %u\n"
+        "flatearth_heap_largest_free_block_bytes{region=\"psram\"} %u\n"
+        "# TYPE flatearth_wifi_rssi_dbm gauge\n"
+        "flatearth_wifi_rssi_dbm %d\n",
+        (unsigned long)(millis() / 1000),
+        SATTYPE_NAME, frames,
+        SATTYPE_NAME, (unsigned)bytes,
+        (unsigned long)cacheWrites, (unsigned long)cacheWriteBytes, (unsigned long)evictions,
+        (unsigned long)demotions, (unsigned long)demotionBytesSaved,
+        (unsigned long)downloads, (unsigned long)downloadFailures, (unsigned long)downloadBytes,
+        (unsigned long)downloadMsTotal, (unsigned long)lastLatencyMs, (unsigned long)lastThroughputBps,
+        (unsigned long)downloadRetries, (unsigned long)wastedBytes, (unsigned long)resumedBytes,
+        (unsigned long)framesDrawn, (unsigned long)frameFailures, (unsigned long)decodeUsTotal, (unsigned long)blitUsTotal,
+        (unsigned long)lastDecodeUs, (unsigned long)lastBlitUs, fps,
+        (unsigned long)prefetchHits, (unsigned long)prefetchMisses, prefetchDepth,
+        (unsigned long)liveFrames, (unsigned long)lastFirstPixelMs,
+        peerCount, (unsigned long)peerHits, (unsigned long)peerMisses, (unsigned long)peerBytes,
+        (unsigned long)peerServed, (unsigned long)peerServedBytes,
+        (unsigned)heap_caps_get_free_size(MALLOC_CAP_INTERNAL),
+        (unsigned)heap_caps_get_free_size(MALLOC_CAP_SPIRAM),
+        (unsigned)heap_caps_get_largest_free_block(MALLOC_CAP_INTERNAL),
+        (unsigned)heap_caps_get_largest_free_block(MALLOC_CAP_SPIRAM),
+        (int)WiFi.RSSI());
+    if (n < 0) return 0;
+
+    // Per-format draw cost, labelled by stored format.
+    static const char *FAMILIES[5] = {"frames_total", "decode_microseconds_total",
+                                      "blit_microseconds_total", "bytes_total", "tiles_total"};
+    for (int k = 0; k < 5 && (size_t)n < len; k++) {
+        n += snprintf(buf + n, len - n, "# TYPE flatearth_format_%s counter\n", FAMILIES[k]);
+        for (int i = 0; i < 2 && (size_t)n < len; i++) {
+            const FormatStats& f = formats[i];
+            uint32_t v = k == 0 ? f.frames : k == 1 ? f.decodeUs : k == 2 ? f.blitUs
+                       : k == 3 ? f.bytes : f.tiles;
+            n += snprintf(buf + n, len - n, "flatearth_format_%s{format=\"%s\"} %lu\n",
+                          FAMILIES[k], FORMAT_NAMES[i], (unsigned long)v);
+        }
+    }
+
+    // Boot phases are fixed after setup(); exposed so a slow boot shows up on
+    // the same dashboard as everything else.
+    if ((size_t)n < len)
+        n += snprintf(buf + n, len - n, "# TYPE flatearth_boot_phase_milliseconds gauge\n");
+    for (int i = 0; i < bootPhaseCount && (size_t)n < len; i++)
+        n += snprintf(buf + n, len - n, "flatearth_boot_phase_milliseconds{phase=\"%s\"} %lu\n",
+                      bootPhases[i].name, (unsigned long)bootPhases[i].ms);
+    return min((size_t)n, len - 1);
+}
+
+// ── HTTP server ───────────────────────────────────────────────────────────────
+
+static void handleStatus() {
+    size_t n = metrics.renderJson(_body, sizeof(_body));
+    _server.send_P(200, "application/json", _body, n);
+}
+
+static void handleMetrics() {
+    size_t n = metrics.renderPrometheus(_body, sizeof(_body));
+    _server.send_P(200, "text/plain; version=0.0.4", _body, n);
+}
+
+// WebServer::handleClient() only does work when a request is waiting, so the
+// poll interval bounds scrape latency while keeping the task almost idle.
+void Metrics::serverTask(void *arg) {
+    _server.on("/status", HTTP_GET, handleStatus);
+    _server.on("/metrics", HTTP_GET, handleMetrics);
+    if (PEER_CACHE_ENABLED)
+        _server.on("/frame", HTTP_GET, []() { PeerCache::serve(_server); });
+    _server.onNotFound([]() { _server.send(404, "text/plain", "Try /status or /metrics\n"); });
+    _server.begin();
+    if (DEBUG_ENABLED)
+        Serial.printf("Metrics on http://%s:%d/metrics\n",
+                      WiFi.localIP().toString().c_str(), METRICS_PORT);
+
+    for (;;) {
+        _server.handleClient();
+        vTaskDelay(pdMS_TO_TICKS(METRICS_POLL_MS));
+    }
+}
+
+void Metrics::startServer() {
+    if (serverStarted) return;
+    serverStarted = true;
+    xTaskCreatePinnedToCore(serverTask, "metrics", METRICS_TASK_STACK, nullptr,
+                            METRICS_TASK_PRIORITY, nullptr, METRICS_TASK_CORE);
+}
@@ -0,0 +1,163 @@
+// MissCache.cpp — negative cache for satellite slots that failed to download.
+
+#include "MissCache.h"
+#include <LittleFS.h>
+#include <time.h>
+
+// Single global instance used by ImageDownloader and main.
+MissCache missCache;
+
+// On-flash table header. Bump MISS_TABLE_VERSION whenever MissEntry changes so
+// an old table is discarded instead of being misread.
+static const uint32_t MISS_TABLE_MAGIC   = 0x5353494D;  // "MISS"
+static const uint32_t MISS_TABLE_VERSION = 1;
+
+// ── Private helpers ───────────────────────────────────────────────────────────
+
+String MissCache::tablePath() {
+    return "/meta/" + String(SATTYPE_NAME) + ".miss";
+}
+
+int MissCache::find(const char* timestamp) const {
+    for (int i = 0; i < count; i++) {
+        if (strcmp(entries[i].timestamp, timestamp) == 0) return i;
+    }
+    return -1;
+}
+
+// Backoff schedule, doubling per consecutive failure:
+//   404 / 410  — the slot was probably never published. Starts at
+//                MISS_BACKOFF_NOTFOUND_S (a late NOAA upload still gets picked
+//                up) and gives up entirely after MISS_NOTFOUND_MAX_TRIES.
+//   304        — the "latest" image has not changed yet (Meteosat); poll
+//                again after MISS_BACKOFF_NOTMODIFIED_S, capped like transients.
+//   429        — rate limited; starts at MISS_BACKOFF_RATELIMIT_S.
+//   other 4xx  — request rejected (e.g. ImageKit origin misconfigured);
+//                unlikely to fix itself soon, starts at MISS_BACKOFF_CLIENT_S.
+//   5xx, <= 0  — server or network trouble; starts at MISS_BACKOFF_TRANSIENT_S
+//                and is capped at MISS_BACKOFF_TRANSIENT_MAX_S so the frame is
+//                fetched soon after connectivity recovers.
+uint32_t MissCache::backoffSeconds(int httpCode, uint8_t failures) {
+    uint32_t base, cap;
+    if (httpCode == 404 || httpCode == 410) {
+        if (failures >= MISS_NOTFOUND_MAX_TRIES) return UINT32_MAX;
+        base = MISS_BACKOFF_NOTFOUND_S;
+        cap  = MISS_BACKOFF_MAX_S;
+    } else if (httpCode == 304) {
+        base = MISS_BACKOFF_NOTMODIFIED_S;
+        cap  = MISS_BACKOFF_TRANSIENT_MAX_S;
+    } else if (httpCode == 429) {
+        base = MISS_BACKOFF_RATELIMIT_S;
+        cap  = MISS_BACKOFF_MAX_S;
+    } else if (httpCode >= 400 && httpCode < 500) {
+        base = MISS_BACKOFF_CLIENT_S;
+        cap  = MISS_BACKOFF_MAX_S;
+    } else {
+        base = MISS_BACKOFF_TRANSIENT_S;
+        cap  = MISS_BACKOFF_TRANSIENT_MAX_S;
+    }
+
+    uint8_t  shift = failures > 1 ? failures - 1 : 0;
+    uint32_t delay = shift >= 16 ? cap : base << shift;
+    return delay < cap ? delay : cap;
+}
+
+// ── Public methods ────────────────────────────────────────────────────────────
+
+// Read the persisted table. A missing, truncated, or version-mismatched file
+// simply starts an empty table — the worst case is one extra round trip per
+// missing slot.
+void MissCache::begin() {
+    count = 0;
+    dirty = false;
+
+    if (!LittleFS.exists("/meta")) LittleFS.mkdir("/meta");
+
+    File file = LittleFS.open(tablePath(), "r");
+    if (!file) return;
+
+    uint32_t header[3] = {0, 0, 0};  // magic, version, entry count
+    if (file.read((uint8_t *)header, sizeof(header)) == sizeof(header) &&
+        header[0] == MISS_TABLE_MAGIC && header[1] == MISS_TABLE_VERSION &&
+        header[2] <= MISS_CACHE_SIZE) {
+        size_t bytes = header[2] * sizeof(MissEntry);
+        if (file.read((uint8_t *)entries, bytes) == bytes) count = header[2];
+    }
+    file.close();
+
+    if (DEBUG_ENABLED && count > 0)
+        Serial.printf("Miss cache: %d slot(s) in backoff\n", count);
+}
+
+bool MissCache::shouldSkip(const char* timestamp) {
+    int i = find(timestamp);
+    if (i < 0) return false;
+    return (uint32_t)time(nullptr) < entries[i].retryAt;
+}
+
+// Add or update the entry for <timestamp>. When the table is full, the entry
+// with the oldest timestamp is replaced — it is the first to leave the window.
+void MissCache::recordFailure(const char* timestamp, int httpCode) {
+    int i = find(timestamp);
+    if (i < 0) {
+        if (count < MISS_CACHE_SIZE) {
+            i = count++;
+        } else {
+            i = 0;
+            for (int j = 1; j < count; j++) {
+                if (strcmp(entries[j].timestamp, entries[i].timestamp) < 0) i = j;
+            }
+        }
+        strlcpy(entries[i].timestamp, timestamp, sizeof(entries[i].timestamp));
+        entries[i].failures = 0;
+    }
+
+    MissEntry &e = entries[i];
+    if (e.failures < UINT8_MAX) e.failures++;
+    e.httpCode = (int16_t)httpCode;
+
+    uint32_t wait = backoffSeconds(httpCode, e.failures);
+    uint32_t now  = (uint32_t)time(nullptr);
+    e.retryAt = (wait == UINT32_MAX || now > UINT32_MAX - wait) ? UINT32_MAX : now + wait;
+    dirty = true;
+
+    if (DEBUG_ENABLED) {
+        if (e.retryAt == UINT32_MAX)
+            Serial.printf("Miss %s (HTTP %d) — giving up after %d tries\n",
+                          e.timestamp, httpCode, e.failures);
+        else
+            Serial.printf("Miss %s (HTTP %d) — retry in %lu s\n",
+                          e.timestamp, httpCode, (unsigned long)wait);
+    }
+}
+
+void MissCache::recordSuccess(const char* timestamp) {
+    int i = find(timestamp);
+    if (i < 0) return;
+    entries[i] = entries[--count];  // order is irrelevant; swap-remove
+    dirty = true;
+}
+
+void MissCache::prune(const char* oldestTimestamp) {
+    for (int i = count - 1; i >= 0; i--) {
+        if (strcmp(entries[i].timestamp, oldestTimestamp) < 0) {
+            entries[i] = entries[--count];
+            dirty = true;
+        }
+    }
+}
+
+void MissCache::save() {
+    if (!dirty) return;
+
+    File file = LittleFS.open(tablePath(), "w", true);
+    if (!file) {
+        if (DEBUG_ENABLED) Serial.println("Miss cache: cannot open table for write");
+        return;
+    }
+    uint32_t header[3] = {MISS_TABLE_MAGIC, MISS_TABLE_VERSION, (uint32_t)count};
+    file.write((const uint8_t *)header, sizeof(header));
+    file.write((const uint8_t *)entries, count * sizeof(MissEntry));
+    file.close();
+    dirty = false;
+}
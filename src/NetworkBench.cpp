@@ -0,0 +1,138 @@
+// NetworkBench.cpp — on-device download soak/benchmark (bench_network env only).
+
+#ifdef NETWORK_BENCH
+
+#include "NetworkBench.h"
+#include "config.h"
+#include "Display.h"
+#include "ImageCache.h"
+#include "ImageDownloader.h"
+#include "Metrics.h"
+#include "MissCache.h"
+#include "Timeline.h"
+#include <LittleFS.h>
+
+// Outcome of one backfill pass.
+struct PassStats {
+    int      attempts  = 0;  // Requests that reached the network
+    int      fetched   = 0;
+    int      failed    = 0;
+    int      timeouts  = 0;  // Failures that took at least DOWNLOAD_TIMEOUT_MS
+    int      backedOff = 0;  // Slots skipped by the negative cache
+    uint32_t okMs      = 0;  // Time spent on successful downloads
+    uint32_t failMs    = 0;  // Time spent on failed attempts = retry cost
+    uint32_t wallMs    = 0;
+};
+
+// One pass in sync order: newest slot first, then the rest coarse to fine.
+// Unlike the sync task, every slot is fetched regardless of source, so
+// Meteosat runs exercise the cache-bust URL shape too.
+static PassStats runPass(Timeline& timeline) {
+    PassStats s;
+    const int n = timeline.count();
+    unsigned long passStart = millis();
+    static int order[NROFIMAGESTOSHOW];
+    timeline.backfillOrder(order);
+
+    for (int k = 0; k < n; k++) {
+        const char *ts = timeline.timestamp(k == 0 ? n - 1 : order[k - 1]);
+        if (cache.contains(ts)) continue;
+        if (missCache.shouldSkip(ts)) { s.backedOff++; continue; }
+
+        unsigned long start = millis();
+        bool ok = ImageDownloader::downloadImage(ts);
+        uint32_t ms = millis() - start;
+
+        s.attempts++;
+        if (ok) {
+            s.fetched++;
+            s.okMs += ms;
+        } else {
+            s.failed++;
+            s.failMs += ms;
+            if (ms >= DOWNLOAD_TIMEOUT_MS) s.timeouts++;
+        }
+    }
+    s.wallMs = millis() - passStart;
+    return s;
+}
+
+static int cachedSlots(Timeline& timeline) {
+    int cached = 0;
+    for (int i = 0; i < timeline.count(); i++) {
+        if (cache.contains(timeline.timestamp(i))) cached++;
+    }
+    return cached;
+}
+
+void runNetworkBench() {
+    Serial.println(F("\n=== Network bench ==="));
+    Serial.printf("  Endpoint: %s\n", IMAGEKIT_ENDPOINT);
+    showStatus("Network bench...");
+
+    // Always start cold so runs are comparable.
+    LittleFS.begin(true);
+    LittleFS.format();
+    LittleFS.end();
+    if (!cache.begin()) {
+        Serial.println(F("  Cache init failed"));
+        for (;;) delay(1000);
+    }
+    missCache.begin();
+
+    Timeline timeline;
+    while (!timeline.refresh()) delay(500);
+    const int n = timeline.count();
+
+    unsigned long benchStart   = millis();
+    unsigned long completeAt   = 0;
+    uint32_t      totalFailMs  = 0;
+    int           totalRetries = 0;  // Attempts after a slot's first failure
+
+    for (int pass = 1; pass <= BENCH_MAX_PASSES; pass++) {
+        PassStats s = runPass(timeline);
+        cache.flush(CACHE_FLUSH_TIMEOUT_MS);
+        int cached = cachedSlots(timeline);
+
+        if (pass > 1) totalRetries += s.attempts;
+        totalFailMs += s.failMs;
+
+        Serial.printf("  Pass %d: %d attempts, %d fetched, %d failed (%d timeouts), "
+                      "%d backed off — %lu ms, %lu ms lost to failures, %d/%d cached\n",
+                      pass, s.attempts, s.fetched, s.failed, s.timeouts, s.backedOff,
+                      (unsigned long)s.wallMs, (unsigned long)s.failMs, cached, n);
+        if (s.fetched > 0)
+            Serial.printf("          avg %lu ms per successful download\n",
+                          (unsigned long)(s.okMs / s.fetched));
+
+        if (cached == n) {
+            completeAt = millis();
+            break;
+        }
+        // Give transient failures time to leave their (doubling) backoff window.
+        if (pass < BENCH_MAX_PASSES)
+            delay(min((uint32_t)BENCH_RETRY_WAIT_MS << (pass - 1),
+                      (uint32_t)(MISS_BACKOFF_TRANSIENT_MAX_S + 1) * 1000));
+    }
+
+    Serial.println(F("  ---"));
+    if (completeAt)
+        Serial.printf("  Backfill complete: %d frames in %lu ms\n", n,
+                      (unsigned long)(completeAt - benchStart));
+    else
+        Serial.printf("  Backfill incomplete after %d passes: %d/%d cached\n",
+                      BENCH_MAX_PASSES, cachedSlots(timeline), n);
+    Serial.printf("  Retry cost: %d retries, %lu ms spent on failed attempts\n",
+                  totalRetries, (unsigned long)totalFailMs);
+
+    static char json[METRICS_BODY_SIZE];
+    metrics.renderJson(json, sizeof(json));
+    Serial.print(F("  Metrics: "));
+    Serial.print(json);
+    Serial.println(F("====================="));
+
+    showStatus("Bench done", 0x07E0);
+    for (;;) delay(1000);
+}
+
+#endif
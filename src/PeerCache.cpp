@@ -0,0 +1,96 @@
+// PeerCache.cpp — share cached frames with other FlatEarth units on the LAN.
+
+#include "PeerCache.h"
+#include "ImageCache.h"
+#include "Metrics.h"
+#include <ESPmDNS.h>
+#include <WebServer.h>
+#include <WiFi.h>
+
+// Single global instance; the sync task discovers and fetches, the metrics
+// server task serves.
+PeerCache peerCache;
+
+// ── Public methods ────────────────────────────────────────────────────────────
+
+// Peers only use each other if satellite, display size and quality all
+// match, so those go into TXT records and discovery can filter on them.
+void PeerCache::begin() {
+    if (started) return;
+    if (!MDNS.begin(DEVICENAME)) {
+        if (DEBUG_ENABLED) Serial.println("mDNS failed to start, peer cache off");
+        return;
+    }
+    char value[8];
+    MDNS.addService("flatearth", "tcp", METRICS_PORT);
+    MDNS.addServiceTxt("flatearth", "tcp", "sat", SATTYPE_NAME);
+    snprintf(value, sizeof(value), "%d", DISPLAY_WIDTH);
+    MDNS.addServiceTxt("flatearth", "tcp", "w", value);
+    snprintf(value, sizeof(value), "%d", DISPLAY_HEIGHT);
+    MDNS.addServiceTxt("flatearth", "tcp", "h", value);
+    snprintf(value, sizeof(value), "%d", JPEG_QUALITY);
+    MDNS.addServiceTxt("flatearth", "tcp", "q", value);
+    started = true;
+    if (DEBUG_ENABLED) Serial.printf("mDNS: %s.local, sharing frames on port %d\n", DEVICENAME, METRICS_PORT);
+}
+
+void PeerCache::refresh() {
+    if (!started) return;
+    if (refreshed && millis() - refreshedAt < PEER_REFRESH_MS) return;
+    refreshed   = true;
+    refreshedAt = millis();
+
+    const int found = MDNS.queryService("flatearth", "tcp");
+    const IPAddress self = WiFi.localIP();
+    peerCount = 0;
+    for (int i = 0; i < found && peerCount < PEER_MAX; i++) {
+        if (MDNS.address(i) == self) continue;
+        if (MDNS.txt(i, "sat") != SATTYPE_NAME ||
+            MDNS.txt(i, "w").toInt() != DISPLAY_WIDTH ||
+            MDNS.txt(i, "h").toInt() != DISPLAY_HEIGHT ||
+            MDNS.txt(i, "q").toInt() != JPEG_QUALITY) continue;
+        peers[peerCount].address = MDNS.address(i);
+        peers[peerCount].port    = MDNS.port(i);
+        peerCount++;
+    }
+    metrics.setPeerCount(peerCount);
+    if (DEBUG_ENABLED)
+        Serial.printf("Peers: %d of %d unit(s) on the LAN match this one\n", peerCount, found);
+}
+
+void PeerCache::drop(int i) {
+    if (i < 0 || i >= peerCount) return;
+    memmove(&peers[i], &peers[i + 1], (peerCount - i - 1) * sizeof(Peer));
+    peerCount--;
+    metrics.setPeerCount(peerCount);
+}
+
+// The content hash goes along as X-Frame-Hash so the receiver can verify the
+// body end to end before caching it.
+void PeerCache::serve(WebServer& server) {
+    const String ts   = server.arg("ts");
+    const int    q    = server.arg("q").toInt();
+    const int    tier = q == JPEG_QUALITY ? 0 : q == CACHE_AGED_QUALITY ? 1 : -1;
+
+    File     file;
+    uint32_t hash = 0;
+    if (server.arg("sat") == SATTYPE_NAME &&
+        server.arg("w").toInt() == DISPLAY_WIDTH &&
+        server.arg("h").toInt() == DISPLAY_HEIGHT &&
+        tier >= 0 && ts.length() > 0 && ts.length() < 16) {
+        file = cache.openForPeer(ts.c_str(), tier, &hash);
+    }
+    if (!file) {
+        server.send(404, "text/plain", "Frame not cached here\n");
+        return;
+    }
+
+    if (hash) {
+        char hex[9];
+        snprintf(hex, sizeof(hex), "%08lx", (unsigned long)hash);
+        server.sendHeader("X-Frame-Hash", hex);
+    }
+    size_t sent = server.streamFile(file, "image/jpeg");
+    file.close();
+    metrics.recordPeerServed(sent);
+}
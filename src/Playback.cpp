@@ -0,0 +1,392 @@
+// Playback.cpp — touch-driven animation engine for the cached satellite window.
+
+#include "Playback.h"
+#include "config.h"
+#include "Display.h"
+#include "ImageCache.h"
+#include "Metrics.h"
+#include "AllocAudit.h"
+#include "FrameCodec.h"
+#include "JpegDecoder.h"
+#include "Prefetch.h"
+
+// Single global instance driven from loop().
+Playback player;
+
+// Playback speed steps as a percentage of the base rate (FRAME_DELAY_MS).
+static const uint16_t SPEED_PERCENT[] = {25, 50, 100, 200, 400};
+static const uint8_t  SPEED_STEPS     = sizeof(SPEED_PERCENT) / sizeof(SPEED_PERCENT[0]);
+
+// With CACHE_RLE_FRAMES, the first JPEG decode of a frame is teed into this
+// encoder so the cache can store the pre-decoded copy. Only the loop task
+// draws, so one static encoder suffices.
+static RleEncoder _encoder;
+
+static void teeTile(int16_t x, int16_t y, uint16_t w, uint16_t h, const uint16_t *bitmap) {
+    _encoder.addTile(x, y, w, h, bitmap);
+}
+
+// ── Public methods ────────────────────────────────────────────────────────────
+
+void Playback::begin() {
+    AllocAudit::watchCurrentTask();
+    if (speedIndex >= SPEED_STEPS) speedIndex = SPEED_STEPS - 1;
+    liveLock = xSemaphoreCreateMutex();
+    initTouch();
+    timeline.refresh();
+    cachedValid = false;
+    if (timeline.count() > 0) seek(timeline.count() - 1);
+    nextFrameAt = millis() + PLAYBACK_HOLD_MS;
+}
+
+void Playback::tick() {
+    cachedValid = false;  // frames may have arrived since the last tick
+
+    // When the window slides forward, keep pointing at the same frame.
+    if (timeline.refresh()) {
+        if (shownTimestamp[0]) shownSlot = timeline.indexOf(shownTimestamp);
+        if (playTimestamp[0])  playSlot  = timeline.indexOf(playTimestamp);
+    }
+
+    // Take the live hand-off state in one go; the sync task may change it
+    // at any time.
+    char     endedTimestamp[16];
+    uint32_t endedHash;
+    xSemaphoreTake(liveLock, portMAX_DELAY);
+    const bool isLive   = live;
+    const bool ended    = liveEnded;
+    const bool complete = liveComplete;
+    strlcpy(endedTimestamp, liveTimestamp, sizeof(endedTimestamp));
+    endedHash = liveHash;
+    liveEnded = false;
+    xSemaphoreGive(liveLock);
+
+    if (ended) {
+        if (complete) {
+            // The sync task's window may be a step ahead of ours: until this
+            // one catches up, treat the live frame as our newest slot.
+            shownSlot = timeline.indexOf(endedTimestamp);
+            if (shownSlot < 0) shownSlot = timeline.count() - 1;
+            strlcpy(shownTimestamp, endedTimestamp, sizeof(shownTimestamp));
+            setPlayhead(shownSlot);
+            shownHash   = endedHash;
+            direction   = 1;
+            nextFrameAt = millis() + PLAYBACK_HOLD_MS;
+        } else {
+            shownHash   = 0;  // the screen shows a partial frame
+            nextFrameAt = millis();
+        }
+    }
+
+    TouchEvent ev = pollTouch();
+    if (ev.gesture != Gesture::None) handleTouch(ev, isLive);
+    if (isLive) return;
+
+    // A scrub made while the live frame drew lands now.
+    if (deferredSeek >= 0) {
+        seek(deferredSeek);
+        deferredSeek = -1;
+    }
+
+    if (paused || scrubbing || timeline.count() == 0) return;
+    if ((long)(millis() - nextFrameAt) < 0) return;
+    advance();
+}
+
+bool Playback::beginLiveFrame() {
+    xSemaphoreTake(liveLock, portMAX_DELAY);
+    bool granted = !paused && !scrubbing;
+    if (granted) live = true;
+    xSemaphoreGive(liveLock);
+    return granted;
+}
+
+void Playback::endLiveFrame(const char* timestamp, uint32_t hash, bool complete) {
+    xSemaphoreTake(liveLock, portMAX_DELAY);
+    strlcpy(liveTimestamp, timestamp, sizeof(liveTimestamp));
+    liveHash     = hash;
+    liveComplete = complete;
+    liveEnded    = true;
+    live         = false;
+    xSemaphoreGive(liveLock);
+}
+
+// ── Private helpers ───────────────────────────────────────────────────────────
+
+void Playback::handleTouch(const TouchEvent& ev, bool deferDraw) {
+    const int n = timeline.count();
+
+    switch (ev.gesture) {
+    case Gesture::Tap:
+        setHold(!paused, scrubbing);
+        nextFrameAt = millis();
+        if (DEBUG_ENABLED) Serial.println(paused ? "Playback paused" : "Playback resumed");
+        break;
+
+    case Gesture::LongPress:
+        pingPong = !pingPong;
+        if (!pingPong) direction = 1;
+        if (DEBUG_ENABLED) Serial.printf("Ping-pong %s\n", pingPong ? "on" : "off");
+        break;
+
+    case Gesture::SwipeUp:
+        if (speedIndex + 1 < SPEED_STEPS) speedIndex++;
+        if (DEBUG_ENABLED) Serial.printf("Speed %d%%\n", SPEED_PERCENT[speedIndex]);
+        break;
+
+    case Gesture::SwipeDown:
+        if (speedIndex > 0) speedIndex--;
+        if (DEBUG_ENABLED) Serial.printf("Speed %d%%\n", SPEED_PERCENT[speedIndex]);
+        break;
+
+    case Gesture::Scrub:
+        // Map the finger's x position linearly onto the window. Only a change
+        // of slot costs a decode, so dragging is bounded by one frame time.
+        if (n > 0) {
+            int x    = constrain(ev.x, 0, DISPLAY_WIDTH - 1);
+            int slot = (x * (n - 1) + (DISPLAY_WIDTH - 1) / 2) / (DISPLAY_WIDTH - 1);
+            setHold(paused, true);
+            if (deferDraw) deferredSeek = slot;
+            else           seek(slot);
+        }
+        break;
+
+    case Gesture::ScrubEnd:
+        // Stay on the chosen frame; a tap resumes from there.
+        setHold(true, false);
+        break;
+
+    default:
+        break;
+    }
+}
+
+void Playback::setHold(bool pause, bool scrub) {
+    xSemaphoreTake(liveLock, portMAX_DELAY);
+    paused    = pause;
+    scrubbing = scrub;
+    xSemaphoreGive(liveLock);
+}
+
+bool Playback::liveFrameActive() {
+    xSemaphoreTake(liveLock, portMAX_DELAY);
+    bool active = live;
+    xSemaphoreGive(liveLock);
+    return active;
+}
+
+int Playback::followingSlot(int from, int8_t& dir) {
+    int next = nextCachedSlot(from + dir, dir);
+    if (next < 0) {
+        if (pingPong) {
+            dir  = -dir;             // bounce
+            next = nextCachedSlot(from + dir, dir);
+        } else {
+            dir  = 1;                // wrap to the oldest frame
+            next = nextCachedSlot(0, 1);
+        }
+    }
+    if (next < 0) next = nextCachedSlot(timeline.count() - 1, -1);  // one frame (or none) cached
+    return next;
+}
+
+void Playback::advance() {
+    const int n = timeline.count();
+    int slot = playSlot + direction;
+    if (slot < 0 || slot >= n) {
+        if (pingPong && n > 1 && playSlot >= 0 && playSlot < n) {
+            direction = -direction;  // bounce
+            slot      = playSlot + direction;
+        } else {
+            direction = 1;           // wrap to the oldest slot
+            slot      = 0;
+        }
+    }
+
+    int next = nearestCachedSlot(slot);
+    if (next < 0) {
+        nextFrameAt = millis() + frameDelay();
+        return;
+    }
+    setPlayhead(slot);
+
+    // A gap in the cache: the nearest frame is already on screen, so it
+    // simply stays there for this slot's turn.
+    bool held  = next == shownSlot;
+    bool drawn = !held && drawSlot(next, false);
+
+    // Hold on the newest frame before starting the next loop, as the original
+    // fixed loop did between animation passes.
+    bool atNewest = slot == n - 1 && direction > 0;
+    if (atNewest)            nextFrameAt = millis() + PLAYBACK_HOLD_MS;
+    else if (drawn || held)  nextFrameAt = millis() + frameDelay();
+    else                     nextFrameAt = millis();  // duplicate skipped — move on at once
+}
+
+void Playback::setPlayhead(int slot) {
+    playSlot = slot;
+    if (slot >= 0) strlcpy(playTimestamp, timeline.timestamp(slot), sizeof(playTimestamp));
+    else           playTimestamp[0] = '\0';
+}
+
+void Playback::seek(int slot) {
+    int target = nearestCachedSlot(slot);
+    if (target < 0) return;
+    setPlayhead(slot);
+    if (target != shownSlot) drawSlot(target, true);
+}
+
+// Walk the play order from the frame on screen and hand the next frames to
+// the prefetcher. Index lookups only. Every cached slot is its own nearest
+// frame, so the frames advance() draws are the cached slots in play order,
+// whatever gaps the playhead holds across.
+void Playback::planPrefetch() {
+    const char *upcoming[PREFETCH_MAX_DEPTH > 0 ? PREFETCH_MAX_DEPTH : 1];
+    const int   depth = prefetcher.depth();
+    int    n    = 0;
+    int    slot = shownSlot;
+    int8_t dir  = direction;
+    while (n < depth) {
+        slot = followingSlot(slot, dir);
+        if (slot < 0 || slot == shownSlot) break;  // the whole window is ahead already
+        upcoming[n++] = timeline.timestamp(slot);
+    }
+    prefetcher.request(upcoming, n);
+}
+
+bool Playback::isCached(int slot) {
+    if (!cachedValid) {
+        cache.cachedSlots(timeline, cachedBits);
+        cachedValid = true;
+    }
+    return cachedBits[slot / 8] & (1 << (slot % 8));
+}
+
+int Playback::nextCachedSlot(int from, int dir) {
+    for (int i = from; i >= 0 && i < timeline.count(); i += dir) {
+        if (isCached(i)) return i;
+    }
+    return -1;
+}
+
+int Playback::nearestCachedSlot(int slot) {
+    const int n = timeline.count();
+    for (int d = 0; d < n; d++) {
+        if (slot + d < n && slot + d >= 0 && isCached(slot + d)) return slot + d;
+        if (slot - d >= 0 && slot - d < n && isCached(slot - d)) return slot - d;
+    }
+    return -1;
+}
+
+bool Playback::drawSlot(int slot, bool force) {
+    const char *ts   = timeline.timestamp(slot);
+    uint32_t    hash = cache.frameHash(ts);
+
+    // Frames stored before dedup existed may still repeat on flash; skip a
+    // frame whose content is identical to the one already on screen.
+    bool duplicate = !force && hash != 0 && hash == shownHash;
+
+    shownSlot = slot;
+    strlcpy(shownTimestamp, ts, sizeof(shownTimestamp));
+    if (duplicate) {
+        planPrefetch();
+        return false;
+    }
+
+    // Take the frame from the read-ahead ring if it is there; otherwise read
+    // it from flash now.
+    const uint8_t *data;
+    size_t         size;
+    bool           prefetched = prefetcher.take(ts, &data, &size);
+    if (!prefetched) {
+        if (!cache.loadImage(ts)) {
+            planPrefetch();
+            return false;
+        }
+        data = imageBuffer;
+        size = imageSize;
+    }
+
+    // An RLE frame is expanded straight into the panel. A JPEG is decoded as
+    // before and, if enabled, transcoded from the same decode.
+    bool     rle       = isRleFrame(data, size);
+    bool     transcode = false;
+    uint16_t w = 0, h = 0;
+    if (CACHE_RLE_FRAMES && !rle && jpegDecoder.getSize(data, size, &w, &h))
+        transcode = _encoder.begin(w, h);
+
+    lockDisplay();
+    if (liveFrameActive()) {
+        // The sync task took over the display for a live frame while this
+        // one was loading; its frame is newer.
+        unlockDisplay();
+        if (prefetched) prefetcher.release();
+        if (transcode) _encoder.abort();
+        return false;
+    }
+    takeBlitMicros();
+    takeBlitTiles();
+    uint32_t start  = micros();
+    uint32_t blitUs = 0;
+    bool     drawn  = true;
+    if (rle) {
+        drawn = drawRleFrame(data, size, &blitUs);
+    } else {
+        if (transcode) setTileTap(teeTile);
+        drawn = jpegDecoder.draw(0, 0, data, size);
+        setTileTap(nullptr);
+        blitUs = takeBlitMicros();
+    }
+    uint32_t totalUs = micros() - start;
+    unlockDisplay();
+
+    uint32_t tiles = takeBlitTiles();
+    if (drawn) {
+        metrics.recordFrame(totalUs - blitUs, blitUs, rle, size, tiles);
+    } else {
+        if (DEBUG_ENABLED) Serial.printf("Malformed frame %s\n", ts);
+        metrics.recordFrameFailure();
+    }
+    shownHash = hash;
+    if (prefetched) prefetcher.release();
+
+    uint8_t *rleData;
+    size_t   rleSize;
+    if (transcode && _encoder.finish(&rleData, &rleSize)) {
+        if (DEBUG_ENABLED) Serial.printf("Transcoded %s: %d -> %d bytes\n", ts, size, rleSize);
+        // The ring copy is the JPEG; drop it so the next loop loads the .rle.
+        if (cache.cacheTranscoded(ts, rleData, rleSize)) prefetcher.forget(ts);
+    }
+
+    // Start reading the following frames while this one is on screen.
+    planPrefetch();
+
+    if (DEBUG_ENABLED)
+        Serial.printf("Frame %d/%d: %s  Size: %d byte%s\n",
+                      slot + 1, timeline.count(), ts, size, prefetched ? " (prefetched)" : "");
+#ifdef ALLOC_AUDIT
+    reportAllocations();
+#endif
+    return true;
+}
+
+#ifdef ALLOC_AUDIT
+// Print how many heap allocations the loop task made over the last
+// ALLOC_AUDIT_REPORT_FRAMES frames. The application figure should be 0 once
+// imageBuffer has grown to the largest frame in the window.
+void Playback::reportAllocations() {
+    static uint32_t frames = 0, lastApp = 0, lastFs = 0;
+    if (++frames % ALLOC_AUDIT_REPORT_FRAMES != 0) return;
+
+    uint32_t app = AllocAudit::appAllocs(), fs = AllocAudit::fsAllocs();
+    Serial.printf("Alloc audit: %lu app, %lu filesystem allocations in the last %d frames\n",
+                  (unsigned long)(app - lastApp), (unsigned long)(fs - lastFs),
+                  ALLOC_AUDIT_REPORT_FRAMES);
+    lastApp = app;
+    lastFs  = fs;
+}
+#endif
+
+uint32_t Playback::frameDelay() const {
+    return (uint32_t)FRAME_DELAY_MS * 100 / SPEED_PERCENT[speedIndex];
+}
@@ -0,0 +1,175 @@
+// Prefetch.cpp — read-ahead of upcoming cached frames into a RAM ring.
+
+#include "Prefetch.h"
+#include "Metrics.h"
+#include <esp_heap_caps.h>
+
+// Single global instance; playback requests and takes, the task fills.
+Prefetcher prefetcher;
+
+// ── Public methods ────────────────────────────────────────────────────────────
+
+void Prefetcher::begin() {
+    if (PREFETCH_MAX_DEPTH == 0 || task) return;
+
+    const bool psram = psramFound();
+    for (Slot &s : slots) s.buf.psram = psram;
+
+    lock = xSemaphoreCreateMutex();
+    if (!lock) return;
+    adaptDepth();
+    if (xTaskCreatePinnedToCore(prefetchTask, "prefetch", PREFETCH_TASK_STACK, this,
+                                PREFETCH_TASK_PRIORITY, &task, PREFETCH_TASK_CORE) != pdPASS) {
+        task = nullptr;
+        if (DEBUG_ENABLED) Serial.println("Prefetch task failed to start");
+        return;
+    }
+    if (DEBUG_ENABLED)
+        Serial.printf("Prefetch: up to %d frames ahead in %s\n", targetDepth, psram ? "PSRAM" : "internal RAM");
+}
+
+void Prefetcher::request(const char *const *timestamps, int count) {
+    if (!task) return;
+    xSemaphoreTake(lock, portMAX_DELAY);
+    wantedCount = min(count, PREFETCH_MAX_DEPTH);
+    for (int i = 0; i < wantedCount; i++)
+        strlcpy(wanted[i], timestamps[i], sizeof(wanted[i]));
+    xSemaphoreGive(lock);
+    xTaskNotifyGive(task);
+}
+
+bool Prefetcher::take(const char *timestamp, const uint8_t **data, size_t *size) {
+    if (!task) return false;
+    bool hit = false;
+    xSemaphoreTake(lock, portMAX_DELAY);
+    for (Slot &s : slots) {
+        if (s.state != SlotState::Ready || strcmp(s.timestamp, timestamp) != 0) continue;
+        s.state = SlotState::InUse;
+        *data   = s.buf.data;
+        *size   = s.buf.size;
+        hit     = true;
+        break;
+    }
+    xSemaphoreGive(lock);
+    metrics.recordPrefetch(hit);
+    return hit;
+}
+
+void Prefetcher::release() {
+    if (!task) return;
+    xSemaphoreTake(lock, portMAX_DELAY);
+    for (Slot &s : slots)
+        if (s.state == SlotState::InUse) s.state = SlotState::Ready;
+    xSemaphoreGive(lock);
+}
+
+void Prefetcher::forget(const char *timestamp) {
+    if (!task) return;
+    xSemaphoreTake(lock, portMAX_DELAY);
+    for (Slot &s : slots)
+        if (s.state == SlotState::Ready && strcmp(s.timestamp, timestamp) == 0) s.state = SlotState::Empty;
+    xSemaphoreGive(lock);
+}
+
+// ── Private helpers ───────────────────────────────────────────────────────────
+
+// Woken by request(). A request that arrives mid-fill leaves the notification
+// set, so the task goes round again with the new list.
+void Prefetcher::prefetchTask(void *arg) {
+    Prefetcher *self = (Prefetcher *)arg;
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        self->adaptDepth();
+        self->fill();
+    }
+}
+
+bool Prefetcher::isWanted(const char *timestamp) const {
+    for (int i = 0; i < wantedCount; i++)
+        if (strcmp(wanted[i], timestamp) == 0) return true;
+    return false;
+}
+
+// One frame per lock hold: the slot is claimed as Loading under the lock and
+// filled outside it, so take() never waits on a flash read. Only this task
+// touches a Loading slot's buffer.
+void Prefetcher::fill() {
+    for (;;) {
+        char ts[16];
+        int  target = -1;
+
+        xSemaphoreTake(lock, portMAX_DELAY);
+        for (int w = 0; w < wantedCount && w < targetDepth && target < 0; w++) {
+            bool present = false;
+            for (const Slot &s : slots)
+                if (s.state != SlotState::Empty && strcmp(s.timestamp, wanted[w]) == 0) present = true;
+            if (present) continue;
+
+            // Prefer an empty slot; otherwise reuse one holding a frame no
+            // longer wanted.
+            for (int i = 0; i < targetDepth && target < 0; i++)
+                if (slots[i].state == SlotState::Empty) target = i;
+            for (int i = 0; i < targetDepth && target < 0; i++)
+                if (slots[i].state == SlotState::Ready && !isWanted(slots[i].timestamp)) target = i;
+            if (target < 0) break;  // ring full of wanted frames
+
+            strlcpy(ts, wanted[w], sizeof(ts));
+            strlcpy(slots[target].timestamp, ts, sizeof(slots[target].timestamp));
+            slots[target].state = SlotState::Loading;
+        }
+        xSemaphoreGive(lock);
+        if (target < 0) return;
+
+        FrameBuffer buf = slots[target].buf;
+        bool ok = cache.loadImage(ts, buf);
+
+        xSemaphoreTake(lock, portMAX_DELAY);
+        slots[target].buf   = buf;
+        slots[target].state = ok ? SlotState::Ready : SlotState::Empty;
+        if (!ok) {
+            // Missing or corrupt: drop it from the list rather than retrying;
+            // playback falls back to loadImage() and reports it.
+            for (int i = 0; i < wantedCount; i++) {
+                if (strcmp(wanted[i], ts) != 0) continue;
+                memmove(wanted[i], wanted[i + 1], (wantedCount - i - 1) * sizeof(wanted[0]));
+                wantedCount--;
+                break;
+            }
+        }
+        xSemaphoreGive(lock);
+    }
+}
+
+// Budget = what the ring already holds plus free memory above the reserve,
+// so the ring gives memory back when the rest of the firmware needs it. Each
+// frame is budgeted at 1.25× the average to leave room for larger ones.
+void Prefetcher::adaptDepth() {
+    int    frames = 0;
+    size_t bytes  = 0;
+    cache.indexStats(frames, bytes);
+    size_t perFrame = frames > 0 ? bytes / frames : PREFETCH_FRAME_ESTIMATE;
+    perFrame += perFrame / 4;
+
+    const bool psram = slots[0].buf.psram;
+    long freeBytes = (long)heap_caps_get_free_size(psram ? MALLOC_CAP_SPIRAM
+                                                         : MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    long reserve   = psram ? PREFETCH_RESERVE_PSRAM : PREFETCH_RESERVE_INTERNAL;
+
+    xSemaphoreTake(lock, portMAX_DELAY);
+    long held = 0;
+    for (const Slot &s : slots) held += s.buf.capacity;
+    long budget = held + freeBytes - reserve;
+    int  depth  = budget > 0 && perFrame > 0 ? (int)min((long)PREFETCH_MAX_DEPTH, budget / (long)perFrame) : 0;
+
+    for (int i = depth; i < PREFETCH_MAX_DEPTH; i++) {
+        Slot &s = slots[i];
+        if (s.state == SlotState::Loading || s.state == SlotState::InUse) continue;
+        free(s.buf.data);
+        s.buf.data     = nullptr;
+        s.buf.capacity = 0;
+        s.state        = SlotState::Empty;
+    }
+    targetDepth = depth;
+    xSemaphoreGive(lock);
+    metrics.setPrefetchDepth(depth);
+}
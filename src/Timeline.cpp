@@ -0,0 +1,119 @@
+// Timeline.cpp — the animation window as an indexed list of satellite slots.
+
+#include "Timeline.h"
+
+int Timeline::stepMinutes() {
+    return SOURCE_STEP_MIN;
+}
+
+// Sparse spacings never go below the source cadence, and being multiples of
+// it, every sparse slot is also a real image time.
+int Timeline::spacingAt(long ageSeconds) {
+    if (ageSeconds < WINDOW_FULL_HOURS * 3600L) return SOURCE_STEP_MIN;
+    if (ageSeconds < WINDOW_MID_HOURS * 3600L) return max(WINDOW_MID_STEP_MIN, SOURCE_STEP_MIN);
+    return max(WINDOW_FAR_STEP_MIN, SOURCE_STEP_MIN);
+}
+
+// Format a normalised tm struct as the timestamp string for the active source.
+// GOES East/West: "YYYYDDDHHMM"   — day-of-year, minutes snapped to nearest 10.
+// ElektroL:       "YYYYMMDD-HHMM" — calendar date, minutes snapped to nearest 30.
+// Meteosat:       "YYYYMMDD-HH00" — calendar date, snapped to the hour.
+//                 Used only as a cache key; the download URL is always the static
+//                 "latest" EUMETSAT image and does not embed the timestamp.
+void Timeline::formatTimestamp(const struct tm &t, char *buf, size_t len) {
+    switch (SATTYPE) {
+    case ELEKTROL:
+        snprintf(buf, len, "%04d%02d%02d-%02d%02d",
+                 t.tm_year + 1900,
+                 t.tm_mon + 1,
+                 t.tm_mday,
+                 t.tm_hour,
+                 (t.tm_min / 30) * 30);  // snap to 0 or 30
+        break;
+    case METEOSAT:
+    case METEOSAT_IODC:
+        snprintf(buf, len, "%04d%02d%02d-%02d00",
+                 t.tm_year + 1900,
+                 t.tm_mon + 1,
+                 t.tm_mday,
+                 t.tm_hour);  // snap to hour boundary — low-res image updates every 60 min
+        break;
+    case GOES_EAST:
+    case GOES_WEST:
+    default:
+        snprintf(buf, len, "%d%03d%04d",
+                 t.tm_year + 1900,
+                 t.tm_yday + 1,                            // day-of-year, 1-based
+                 t.tm_hour * 100 + (t.tm_min / 10) * 10);  // HHMM, snapped to 10-min
+        break;
+    }
+}
+
+// The newest slot is now − SERVER_LAG_MINUTES, snapped down to the source
+// cadence; only it is compared to decide whether anything moved. When it did,
+// the window is rebuilt by walking back in time: each step snaps to the
+// spacing of the zone the next slot falls in, so sparse slots land on round
+// UTC times (e.g. 00:00, 03:00, 06:00 for a 3 h spacing) and a frame cached
+// at full cadence stays in the window once it ages into a sparse zone.
+// At most NROFIMAGESTOSHOW snprintf calls, once per cadence step; nothing
+// here touches the heap.
+bool Timeline::refresh() {
+    struct tm timeinfo;
+    if (!getLocalTime(&timeinfo, 0)) return false;
+
+    timeinfo.tm_min -= SERVER_LAG_MINUTES;
+    time_t newest = mktime(&timeinfo);
+    newest -= newest % (stepMinutes() * 60);
+    if (slotCount > 0 && times[slotCount - 1] == newest) return false;
+
+    // Collect newest first, then reverse so slot 0 is the oldest.
+    int    n = 0;
+    time_t t = newest;
+    while (n < NROFIMAGESTOSHOW && newest - t < WINDOW_HOURS * 3600L) {
+        times[n++] = t;
+        time_t before = t - 1;
+        t = before - before % (spacingAt(newest - before) * 60);
+    }
+    for (int i = 0; i < n / 2; i++) {
+        time_t swap      = times[i];
+        times[i]         = times[n - 1 - i];
+        times[n - 1 - i] = swap;
+    }
+    for (int i = 0; i < n; i++) {
+        struct tm slot;
+        localtime_r(&times[i], &slot);
+        formatTimestamp(slot, stamps[i], sizeof(stamps[i]));
+    }
+    slotCount = n;
+    return true;
+}
+
+static_assert(BACKFILL_COARSE_STRIDE > 0 &&
+              (BACKFILL_COARSE_STRIDE & (BACKFILL_COARSE_STRIDE - 1)) == 0,
+              "BACKFILL_COARSE_STRIDE must be a power of two");
+
+// A slot <back> places before the newest belongs to the level whose stride is
+// the largest power of two dividing <back> (capped at the coarse stride), so
+// every slot is listed exactly once.
+int Timeline::backfillOrder(int *out) const {
+    int k = 0;
+    for (int stride = BACKFILL_COARSE_STRIDE; stride >= 1; stride /= 2) {
+        for (int back = stride; back < slotCount; back += stride) {
+            if (stride == BACKFILL_COARSE_STRIDE || back % (2 * stride) != 0)
+                out[k++] = slotCount - 1 - back;
+        }
+    }
+    return k;
+}
+
+// Timestamps within one source sort chronologically, so binary search works.
+int Timeline::indexOf(const char* timestamp) const {
+    int lo = 0, hi = slotCount - 1;
+    while (lo <= hi) {
+        int mid = (lo + hi) / 2;
+        int cmp = strcmp(stamps[mid], timestamp);
+        if (cmp == 0) return mid;
+        if (cmp < 0) lo = mid + 1; else hi = mid - 1;
+    }
+    return -1;
+}
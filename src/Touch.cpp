@@ -0,0 +1,168 @@
+// Touch.cpp — SPD2010 touch controller driver and gesture recogniser.
+// The SPD2010 on the Waveshare 1.46B shares the display's package but talks
+// I2C. Its firmware runs a small state machine (BIOS → CPU → point mode) that
+// the host has to nudge along; the sequence below follows Waveshare's
+// reference driver. Registers are 16-bit, sent high byte first.
+
+#include "Touch.h"
+#include "config.h"
+
+#ifdef BOARD_WAVESHARE
+#include <Wire.h>
+
+// ── SPD2010 low-level access ──────────────────────────────────────────────────
+
+enum class Sample : uint8_t { NoData, Down, Up };
+
+static bool writeCommand(uint16_t reg, uint8_t lo, uint8_t hi) {
+    Wire.beginTransmission(WAVESHARE_TOUCH_ADDR);
+    Wire.write(reg >> 8);
+    Wire.write(reg & 0xFF);
+    Wire.write(lo);
+    Wire.write(hi);
+    return Wire.endTransmission() == 0;
+}
+
+static bool readRegister(uint16_t reg, uint8_t *buf, size_t len) {
+    Wire.beginTransmission(WAVESHARE_TOUCH_ADDR);
+    Wire.write(reg >> 8);
+    Wire.write(reg & 0xFF);
+    if (Wire.endTransmission() != 0) return false;
+    if (Wire.requestFrom((uint8_t)WAVESHARE_TOUCH_ADDR, (uint8_t)len) != len) return false;
+    for (size_t i = 0; i < len; i++) buf[i] = Wire.read();
+    return true;
+}
+
+static void clearInterrupt() { writeCommand(0x0200, 0x01, 0x00); }
+static void startCpu()       { writeCommand(0x0400, 0x01, 0x00); }
+static void pointMode()      { writeCommand(0x5000, 0x00, 0x00); }
+static void startScan()      { writeCommand(0x4600, 0x00, 0x00); }
+
+// Read one report. Only the first touch point is used — every gesture the
+// playback engine understands is single-finger.
+static Sample readSample(int16_t *x, int16_t *y) {
+    uint8_t status[4];
+    if (!readRegister(0x2000, status, sizeof(status))) return Sample::NoData;
+
+    bool     pointExists = status[0] & 0x01;
+    bool     gesture     = status[0] & 0x02;
+    bool     aux         = status[0] & 0x08;
+    bool     inBios      = status[1] & 0x40;
+    bool     inCpu       = status[1] & 0x20;
+    bool     cpuRunning  = status[1] & 0x08;
+    uint16_t length      = status[2] | (status[3] << 8);
+
+    if (inBios) { clearInterrupt(); startCpu(); return Sample::NoData; }
+    if (inCpu)  { pointMode(); startScan(); clearInterrupt(); return Sample::NoData; }
+    if (cpuRunning && length == 0) { clearInterrupt(); return Sample::NoData; }
+
+    if (!pointExists && !gesture) {
+        if (cpuRunning && aux) clearInterrupt();
+        return Sample::NoData;
+    }
+
+    uint8_t report[64];
+    if (length > sizeof(report)) length = sizeof(report);
+    if (!readRegister(0x0003, report, length)) return Sample::NoData;
+
+    Sample result = Sample::Up;
+    if (pointExists && length >= 10 && report[4] <= 0x0A) {
+        *x = ((report[7] & 0xF0) << 4) | report[5];
+        *y = ((report[7] & 0x0F) << 8) | report[6];
+        result = Sample::Down;
+    }
+
+    // Drain any follow-up packets until the controller reports "done" (0x82).
+    for (int guard = 0; guard < 4; guard++) {
+        uint8_t hdp[8];
+        if (!readRegister(0xFC02, hdp, sizeof(hdp))) break;
+        if (hdp[5] == 0x82) { clearInterrupt(); break; }
+        if (hdp[5] != 0x00) break;
+        uint16_t next = hdp[2] | (hdp[3] << 8);
+        if (next > sizeof(report)) next = sizeof(report);
+        if (next == 0 || !readRegister(0x0003, report, next)) break;
+    }
+    return result;
+}
+
+// ── Gesture recogniser ────────────────────────────────────────────────────────
+
+static bool          _touching    = false;
+static bool          _scrubbing   = false;
+static bool          _longPressed = false;
+static int16_t       _startX, _startY, _lastX, _lastY;
+static unsigned long _startMs, _lastSeenMs;
+
+bool initTouch() {
+    pinMode(WAVESHARE_TOUCH_INT_PIN, INPUT_PULLUP);
+    Wire.begin(WAVESHARE_TOUCH_SDA_PIN, WAVESHARE_TOUCH_SCL_PIN, 400000);
+
+    uint8_t status[4];
+    if (!readRegister(0x2000, status, sizeof(status))) {
+        if (DEBUG_ENABLED) Serial.println("Touch controller not responding");
+        return false;
+    }
+    if (DEBUG_ENABLED) Serial.println("Touch init OK");
+    return true;
+}
+
+// The SPD2010 keeps its interrupt line low while it has unread data, so the
+// I2C bus is only touched when there is something to read. A finger counts as
+// lifted when the controller says so, or when reports stop for TOUCH_RELEASE_MS.
+TouchEvent pollTouch() {
+    TouchEvent    ev  = {Gesture::None, 0, 0};
+    unsigned long now = millis();
+
+    int16_t x = 0, y = 0;
+    Sample  s = digitalRead(WAVESHARE_TOUCH_INT_PIN) == LOW ? readSample(&x, &y) : Sample::NoData;
+
+    if (s == Sample::Down) {
+        if (!_touching) {
+            _touching = true;
+            _scrubbing = _longPressed = false;
+            _startX = x; _startY = y;
+            _startMs = now;
+        }
+        _lastX = x; _lastY = y;
+        _lastSeenMs = now;
+
+        int16_t dx = abs(x - _startX), dy = abs(y - _startY);
+        if (!_scrubbing && !_longPressed && dx > TOUCH_MOVE_PX && dx > dy) _scrubbing = true;
+        if (_scrubbing) ev = {Gesture::Scrub, x, y};
+        return ev;
+    }
+
+    if (_touching && (s == Sample::Up || now - _lastSeenMs > TOUCH_RELEASE_MS)) {
+        _touching = false;
+        int16_t dx = _lastX - _startX, dy = _lastY - _startY;
+        if (_scrubbing) {
+            ev = {Gesture::ScrubEnd, _lastX, _lastY};
+        } else if (!_longPressed && abs(dy) > TOUCH_MOVE_PX && abs(dy) > abs(dx)) {
+            ev = {dy < 0 ? Gesture::SwipeUp : Gesture::SwipeDown, _lastX, _lastY};
+        } else if (!_longPressed && abs(dx) <= TOUCH_MOVE_PX && abs(dy) <= TOUCH_MOVE_PX) {
+            ev = {Gesture::Tap, _lastX, _lastY};
+        }
+        return ev;
+    }
+
+    // Long press fires while the finger is still down, so the user gets
+    // feedback without having to guess when to let go.
+    if (_touching && !_scrubbing && !_longPressed && now - _startMs >= TOUCH_LONGPRESS_MS &&
+        abs(_lastX - _startX) <= TOUCH_MOVE_PX && abs(_lastY - _startY) <= TOUCH_MOVE_PX) {
+        _longPressed = true;
+        ev = {Gesture::LongPress, _lastX, _lastY};
+    }
+    return ev;
+}
+
+#else  // no touch controller on this board
+
+bool initTouch() {
+    return false;
+}
+
+TouchEvent pollTouch() {
+    return {Gesture::None, 0, 0};
+}
+
+#endif
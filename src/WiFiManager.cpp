@@ -4,6 +4,9 @@
 #include <WiFi.h>
 #include "config.h"
 #include "Display.h"
+#include "ImageCache.h"
+#include "Metrics.h"
+#include "PeerCache.h"
 
 // Attempt to connect to one WiFi network, showing the SSID on screen.
 // Disconnects any in-progress connection first to avoid ESP_ERR_WIFI_CONN errors.
@@ -40,6 +43,30 @@ void setupWiFi() {
         if (!tryConnect(WIFI_SSID2, WIFI_PASSWORD2)) {
             showStatus("No WiFi!", 0xF800);
             if (DEBUG_ENABLED) Serial.println("Both networks failed.");
+            return;
         }
     }
+    startNetworkServices();
+}
+
+void reconnectWiFi() {
+    static bool          backup    = true;  // flips to the primary on the first call
+    static unsigned long startedAt = 0;
+    if (startedAt && millis() - startedAt < (unsigned long)WIFI_CONNECT_ATTEMPTS * WIFI_CONNECT_DELAY_MS)
+        return;  // still trying the last network
+
+    backup    = !backup;
+    startedAt = millis();
+    const char *ssid = backup ? WIFI_SSID2 : WIFI_SSID1;
+    if (DEBUG_ENABLED) Serial.printf("WiFi lost, reconnecting to %s\n", ssid);
+    WiFi.disconnect();
+    WiFi.begin(ssid, backup ? WIFI_PASSWORD2 : WIFI_PASSWORD1);
+}
+
+void startNetworkServices() {
+    if (!cache.ready() || WiFi.status() != WL_CONNECTED) return;
+    // The metrics server listens on all interfaces, so it only needs starting
+    // once; it keeps serving across reconnects.
+    metrics.startServer();
+    if (PEER_CACHE_ENABLED) peerCache.begin();
 }
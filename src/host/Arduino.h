@@ -0,0 +1,56 @@
+// Arduino.h — host shim for the native_render, native_flash and native_rle
+// envs (see RenderBench.cpp, FlashBenchMain.cpp and RleCodecTest.cpp). Just
+// enough of the Arduino core for Display.cpp, FlashBench.cpp, FrameCodec.cpp
+// and the library stand-ins to build on Linux/macOS: timing, GPIO no-ops,
+// Serial, and a board without PSRAM.
+
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+#include <algorithm>
+#include <chrono>
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+using std::max;
+using std::min;
+
+#define HIGH   1
+#define LOW    0
+#define OUTPUT 1
+#define INPUT  0
+
+inline void pinMode(uint8_t, uint8_t) {}
+inline void digitalWrite(uint8_t, uint8_t) {}
+
+inline uint32_t micros() {
+    using namespace std::chrono;
+    static const steady_clock::time_point start = steady_clock::now();
+    return (uint32_t)duration_cast<microseconds>(steady_clock::now() - start).count();
+}
+
+inline uint32_t millis() { return micros() / 1000; }
+
+inline bool psramFound() { return false; }
+
+#define F(s) (s)
+
+// Serial goes to stderr so the bench report on stdout stays machine-readable.
+class HostSerial {
+public:
+    void print(const char *s) { fputs(s, stderr); }
+    void println(const char *s = "") { fprintf(stderr, "%s\n", s); }
+    void printf(const char *fmt, ...) {
+        va_list args;
+        va_start(args, fmt);
+        vfprintf(stderr, fmt, args);
+        va_end(args);
+    }
+};
+
+inline HostSerial Serial;
+
+#endif
@@ -0,0 +1,291 @@
+// Arduino_GFX_Library.h — host stand-in for moononournation/GFX Library for
+// Arduino, used by the native_render and native_rle envs (see RenderBench.cpp).
+// Mirrors the classes Display.cpp instantiates, so it builds unchanged. The
+// bus drives no pins. It writes the panel's memory the way the controller
+// does (CASET/RASET set a window, RAMWR starts filling it), so whatever path
+// the pixels take, gram() shows what the panel would. Each transaction is
+// charged the time the real driver would take: a fixed cost, plus its bytes
+// clocked out over the lines the driver uses (RENDER_BENCH_* in config.h).
+// The call structure follows the library: a blit goes through the virtual
+// draw16bitRGBBitmap(), the panel's address-window cache and the bus's
+// writePixels(), so output-path changes can be measured on the host.
+//
+// Only rotation 0 is modeled, and text is not rendered (showStatus() only
+// runs at boot).
+
+#ifndef HOST_ARDUINO_GFX_LIBRARY_H
+#define HOST_ARDUINO_GFX_LIBRARY_H
+
+#include <Arduino.h>
+#include <vector>
+#include "config.h"
+
+#define GFX_NOT_DEFINED -1
+
+// ── Bus ───────────────────────────────────────────────────────────────────────
+
+// Modeled cost of everything sent since the last resetStats().
+struct BusStats {
+    uint64_t ns           = 0;
+    uint32_t transactions = 0;
+    uint64_t bytes        = 0;
+};
+
+class Arduino_DataBus {
+public:
+    virtual ~Arduino_DataBus() {}
+
+    virtual bool begin(int32_t speed = GFX_NOT_DEFINED, int8_t dataMode = GFX_NOT_DEFINED) {
+        (void)dataMode;
+        if (speed != GFX_NOT_DEFINED) hz = speed;
+        return true;
+    }
+    virtual void beginWrite() {}
+    virtual void endWrite() {}
+    virtual void writeCommand(uint8_t c) = 0;
+    virtual void writeC8D16D16(uint8_t c, uint16_t d1, uint16_t d2) = 0;
+    virtual void writePixels(uint16_t *data, uint32_t len) = 0;
+    virtual void writeRepeat(uint16_t p, uint32_t len) = 0;
+
+    // Stand-in only.
+    virtual const char *name() const = 0;
+    const BusStats &stats() const { return _stats; }
+    void resetStats() { _stats = BusStats(); }
+
+    // The panel's memory, row-major RGB565. Sized by the panel constructor.
+    void attach(int16_t w, int16_t h) {
+        _gramW = w;
+        _gramH = h;
+        _gram.assign((size_t)w * h, 0);
+    }
+    const uint16_t *gram() const { return _gram.data(); }
+
+protected:
+    Arduino_DataBus(uint32_t hz, uint32_t txnNs) : hz(hz), txnNs(txnNs) {}
+
+    // Controller side of a command: window registers and the RAM write pointer.
+    void command(uint8_t c, uint16_t d1 = 0, uint16_t d2 = 0) {
+        if (c == 0x2A) { _x0 = d1; _x1 = d2; }          // CASET
+        else if (c == 0x2B) { _y0 = d1; _y1 = d2; }     // RASET
+        else if (c == 0x2C) { _cx = _x0; _cy = _y0; }   // RAMWR
+    }
+
+    // Controller side of pixel data: fill the window row by row, a run at a
+    // time so the model stays cheap next to the path being measured. <data>
+    // null means <len> copies of <color>.
+    void store(const uint16_t *data, uint16_t color, uint32_t len) {
+        while (len > 0 && _cy <= _y1) {
+            uint32_t run = min<uint32_t>(len, _x1 - _cx + 1);
+            if (_cy < _gramH && _cx < _gramW) {
+                uint16_t *dst  = &_gram[(size_t)_cy * _gramW + _cx];
+                uint32_t  keep = min<uint32_t>(run, _gramW - _cx);
+                if (data) memcpy(dst, data, keep * sizeof(uint16_t));
+                else      std::fill(dst, dst + keep, color);
+            }
+            if (data) data += run;
+            len -= run;
+            _cx += run;
+            if (_cx > _x1) {
+                _cx = _x0;
+                _cy++;
+            }
+        }
+    }
+
+    // One transaction: <serial> bytes on one data line (commands, QSPI
+    // headers) and <wide> bytes over <lanes> lines (pixels).
+    void transaction(uint32_t serial, uint32_t wide = 0, uint8_t lanes = 1) {
+        const uint64_t bits = (uint64_t)serial * 8 + (uint64_t)wide * 8 / lanes;
+        _stats.ns += txnNs + bits * 1000000000ULL / hz;
+        _stats.transactions++;
+        _stats.bytes += serial + wide;
+    }
+
+    uint32_t hz;
+    uint32_t txnNs;
+    BusStats _stats;
+
+private:
+    std::vector<uint16_t> _gram;
+    uint16_t              _gramW = 0, _gramH = 0;
+    uint16_t              _x0 = 0, _x1 = 0, _y0 = 0, _y1 = 0;  // window
+    uint16_t              _cx = 0, _cy = 0;                    // write pointer
+};
+
+// GC9A01 wiring: 4-wire SPI, one data line. The driver fills the SPI data
+// registers and sends, RENDER_BENCH_SPI_TXN_BYTES at a time; a command and
+// its parameters are separate transactions because DC changes in between.
+class Arduino_ESP32SPI : public Arduino_DataBus {
+public:
+    Arduino_ESP32SPI(int8_t dc, int8_t cs = GFX_NOT_DEFINED, int8_t sck = GFX_NOT_DEFINED,
+                     int8_t mosi = GFX_NOT_DEFINED, int8_t miso = GFX_NOT_DEFINED)
+        : Arduino_DataBus(RENDER_BENCH_SPI_HZ, RENDER_BENCH_SPI_TXN_NS) {
+        (void)dc; (void)cs; (void)sck; (void)mosi; (void)miso;
+    }
+
+    const char *name() const override { return "SPI"; }
+
+    void writeCommand(uint8_t c) override {
+        command(c);
+        transaction(1);
+    }
+
+    void writeC8D16D16(uint8_t c, uint16_t d1, uint16_t d2) override {
+        command(c, d1, d2);
+        transaction(1);
+        transaction(4);
+    }
+
+    void writePixels(uint16_t *data, uint32_t len) override {
+        store(data, 0, len);
+        writeBytes(len * 2);
+    }
+    void writeRepeat(uint16_t p, uint32_t len) override {
+        store(nullptr, p, len);
+        writeBytes(len * 2);
+    }
+
+private:
+    void writeBytes(uint32_t n) {
+        for (; n > RENDER_BENCH_SPI_TXN_BYTES; n -= RENDER_BENCH_SPI_TXN_BYTES)
+            transaction(RENDER_BENCH_SPI_TXN_BYTES);
+        if (n) transaction(n);
+    }
+};
+
+// SPD2010 wiring: QSPI. Every transaction starts with a 4-byte
+// instruction/address header on one line; pixel data then goes over all
+// four, up to RENDER_BENCH_QSPI_TXN_BYTES per DMA transaction.
+class Arduino_ESP32QSPI : public Arduino_DataBus {
+public:
+    Arduino_ESP32QSPI(int8_t cs, int8_t sck, int8_t d0, int8_t d1, int8_t d2, int8_t d3)
+        : Arduino_DataBus(RENDER_BENCH_QSPI_HZ, RENDER_BENCH_QSPI_TXN_NS) {
+        (void)cs; (void)sck; (void)d0; (void)d1; (void)d2; (void)d3;
+    }
+
+    const char *name() const override { return "QSPI"; }
+
+    void writeCommand(uint8_t c) override {
+        command(c);
+        transaction(4);
+    }
+
+    void writeC8D16D16(uint8_t c, uint16_t d1, uint16_t d2) override {
+        command(c, d1, d2);
+        transaction(4 + 4);
+    }
+
+    void writePixels(uint16_t *data, uint32_t len) override {
+        store(data, 0, len);
+        writeBytes(len * 2);
+    }
+    void writeRepeat(uint16_t p, uint32_t len) override {
+        store(nullptr, p, len);
+        writeBytes(len * 2);
+    }
+
+private:
+    void writeBytes(uint32_t n) {
+        for (; n > RENDER_BENCH_QSPI_TXN_BYTES; n -= RENDER_BENCH_QSPI_TXN_BYTES)
+            transaction(4, RENDER_BENCH_QSPI_TXN_BYTES, 4);
+        if (n) transaction(4, n, 4);
+    }
+};
+
+// ── Display ───────────────────────────────────────────────────────────────────
+
+class Arduino_GFX {
+public:
+    Arduino_GFX(int16_t w, int16_t h) : _width(w), _height(h) {}
+    virtual ~Arduino_GFX() {}
+
+    virtual bool begin(int32_t speed = GFX_NOT_DEFINED) = 0;
+    virtual void draw16bitRGBBitmap(int16_t x, int16_t y, uint16_t *bitmap, int16_t w, int16_t h) = 0;
+    virtual void fillScreen(uint16_t color) = 0;
+    virtual void setRotation(uint8_t r) { (void)r; }
+    virtual void invertDisplay(bool) {}
+
+    void   setTextSize(uint8_t) {}
+    void   setTextColor(uint16_t) {}
+    void   setCursor(int16_t, int16_t) {}
+    size_t print(const char *s) { return strlen(s); }
+
+    int16_t width() const { return _width; }
+    int16_t height() const { return _height; }
+
+protected:
+    int16_t _width, _height;
+};
+
+// Shared by both panels, as in the library: the address window is cached, so
+// CASET/RASET go out only when the column or row range changes.
+class Arduino_TFT : public Arduino_GFX {
+public:
+    Arduino_TFT(Arduino_DataBus *bus, int16_t w, int16_t h) : Arduino_GFX(w, h), _bus(bus) {
+        bus->attach(w, h);
+    }
+
+    bool begin(int32_t speed = GFX_NOT_DEFINED) override { return _bus->begin(speed); }
+
+    virtual void writeAddrWindow(int16_t x, int16_t y, uint16_t w, uint16_t h) {
+        if (x != _currentX || w != _currentW) {
+            _bus->writeC8D16D16(0x2A, x, x + w - 1);  // CASET
+            _currentX = x;
+            _currentW = w;
+        }
+        if (y != _currentY || h != _currentH) {
+            _bus->writeC8D16D16(0x2B, y, y + h - 1);  // RASET
+            _currentY = y;
+            _currentH = h;
+        }
+        _bus->writeCommand(0x2C);  // RAMWR
+    }
+
+    // A bitmap inside the panel goes out as one window; one that is clipped
+    // is sent a row at a time, as the library does.
+    void draw16bitRGBBitmap(int16_t x, int16_t y, uint16_t *bitmap, int16_t w, int16_t h) override {
+        const int16_t x0 = max<int16_t>(x, 0), x1 = min<int16_t>(x + w, _width);
+        const int16_t y0 = max<int16_t>(y, 0), y1 = min<int16_t>(y + h, _height);
+        if (x0 >= x1 || y0 >= y1) return;
+
+        _bus->beginWrite();
+        if (x0 == x && x1 == x + w && y0 == y && y1 == y + h) {
+            writeAddrWindow(x, y, w, h);
+            _bus->writePixels(bitmap, (uint32_t)w * h);
+        } else {
+            for (int16_t row = y0; row < y1; row++) {
+                writeAddrWindow(x0, row, x1 - x0, 1);
+                _bus->writePixels(bitmap + (row - y) * w + (x0 - x), x1 - x0);
+            }
+        }
+        _bus->endWrite();
+    }
+
+    void fillScreen(uint16_t color) override {
+        _bus->beginWrite();
+        writeAddrWindow(0, 0, _width, _height);
+        _bus->writeRepeat(color, (uint32_t)_width * _height);
+        _bus->endWrite();
+    }
+
+protected:
+    Arduino_DataBus *_bus;
+    int16_t          _currentX = -1, _currentY = -1;
+    uint16_t         _currentW = 0, _currentH = 0;
+};
+
+class Arduino_GC9A01 : public Arduino_TFT {
+public:
+    Arduino_GC9A01(Arduino_DataBus *bus, int8_t rst = GFX_NOT_DEFINED, uint8_t r = 0,
+                   bool ips = false, int16_t w = 240, int16_t h = 240)
+        : Arduino_TFT(bus, w, h) { (void)rst; (void)r; (void)ips; }
+};
+
+class Arduino_SPD2010 : public Arduino_TFT {
+public:
+    Arduino_SPD2010(Arduino_DataBus *bus, int8_t rst = GFX_NOT_DEFINED, uint8_t r = 0,
+                    bool ips = false, int16_t w = 412, int16_t h = 412)
+        : Arduino_TFT(bus, w, h) { (void)rst; (void)r; (void)ips; }
+};
+
+#endif
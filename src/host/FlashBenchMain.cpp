@@ -0,0 +1,83 @@
+// FlashBenchMain.cpp — host-side flash bench (native_flash envs only).
+// Runs the firmware's flash suite (FlashBench.cpp, built unchanged) on the
+// LittleFS stand-in: real littlefs over a modeled NOR flash the size of the
+// board's partition. First with the mount profile from platformio.ini, then
+// across a sweep of cache and lookahead sizes. Times are modeled flash time
+// (FLASH_BENCH_* in config.h); littlefs's own CPU time is left out, so
+// confirm a chosen profile with bench_flash on a unit. Per-operation detail
+// goes to stderr, the summary table to stdout.
+//
+//   pio run -e native_flash
+//   .pio/build/native_flash/program
+
+#ifdef NATIVE_FLASH_BENCH
+
+#include "config.h"
+#include "FlashBench.h"
+#include <LittleFS.h>
+
+static const uint32_t CACHE_SWEEP[]     = {256, 512, 1024, 2048, 4096};
+static const uint32_t LOOKAHEAD_SWEEP[] = {16, 128, 512};
+
+// RAM littlefs holds while mounted: read and prog caches plus the lookahead
+// bitmap. Each open file adds one more cache.
+static uint32_t mountRam(const LittleFSProfile &p) {
+    return 2 * p.cacheSize + p.lookaheadSize;
+}
+
+static bool runProfile(const char *label, const LittleFSProfile &p) {
+    LittleFS.setProfile(p);
+    if (!LittleFS.format() || !LittleFS.begin()) {
+        printf("%-26s mount failed\n", label);
+        return false;
+    }
+    Serial.printf("%s: cache %u, lookahead %u, block cycles %d\n", label, p.cacheSize,
+                  p.lookaheadSize, p.blockCycles);
+
+    LittleFS.resetStats();
+    FlashBenchResult r;
+    bool ok = runFlashSuite(r);
+    const FlashStats &s = LittleFS.stats();
+    LittleFS.end();
+    if (!ok) {
+        printf("%-26s failed after %d files\n", label, r.files);
+        return false;
+    }
+
+    printf("%-26s %8.0f %8.0f %8.0f %8.2f %8.2f %8u %7u\n", label, r.writeEmpty.kBps(),
+           r.writeFull.kBps(), r.read.kBps(), r.open.avgMs(), r.remove.avgMs(), s.erases,
+           mountRam(p));
+    return true;
+}
+
+int main() {
+    const LittleFSProfile configured;
+    printf("Flash bench: %u KB LittleFS partition, %u blocks of %u bytes, read %u, prog %u, block cycles %d\n",
+           FLASH_BENCH_PARTITION_BYTES / 1024, FLASH_BENCH_PARTITION_BYTES / LittleFSFS::BLOCK_SIZE,
+           LittleFSFS::BLOCK_SIZE, configured.readSize, configured.progSize, configured.blockCycles);
+    printf("Files of %d-%d bytes up to CACHE_FILL_THRESHOLD. Write and read in KB/s, open and\n"
+           "delete in ms, erases over the whole run, fill included.\n\n",
+           FLASH_BENCH_MIN_BYTES, FLASH_BENCH_MAX_BYTES);
+    printf("%-26s %8s %8s %8s %8s %8s %8s %7s\n", "profile", "wr_empty", "wr_full", "read",
+           "open_ms", "del_ms", "erases", "ram_B");
+
+    char label[32];
+    snprintf(label, sizeof(label), "configured %u/%u", configured.cacheSize, configured.lookaheadSize);
+    bool ok = runProfile(label, configured);
+
+    for (uint32_t cache : CACHE_SWEEP) {
+        for (uint32_t lookahead : LOOKAHEAD_SWEEP) {
+            LittleFSProfile p = configured;
+            p.cacheSize     = cache;
+            p.lookaheadSize = lookahead;
+            // littlefs needs the cache to be a multiple of the read and
+            // prog sizes.
+            if (cache % p.readSize || cache % p.progSize) continue;
+            snprintf(label, sizeof(label), "cache %u/lookahead %u", cache, lookahead);
+            ok &= runProfile(label, p);
+        }
+    }
+    return ok ? 0 : 1;
+}
+
+#endif
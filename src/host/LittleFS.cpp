@@ -0,0 +1,178 @@
+// LittleFS.cpp — host stand-in for the Arduino-ESP32 LittleFS library
+// (native_flash envs only); see LittleFS.h.
+
+#ifdef NATIVE_FLASH_BENCH
+
+#include "LittleFS.h"
+
+LittleFSFS LittleFS;
+
+// ── Flash model ───────────────────────────────────────────────────────────────
+
+void LittleFSFS::charge(uint64_t ns) {
+    _stats.ns += ns;
+    _totalNs  += ns;
+}
+
+int LittleFSFS::flashRead(const lfs_config *c, lfs_block_t block, lfs_off_t off, void *buffer, lfs_size_t size) {
+    LittleFSFS *fs = (LittleFSFS *)c->context;
+    memcpy(buffer, &fs->_flash[(size_t)block * BLOCK_SIZE + off], size);
+    fs->_stats.reads++;
+    fs->_stats.readBytes += size;
+    fs->charge(FLASH_BENCH_CALL_NS + (uint64_t)size * FLASH_BENCH_READ_NS_PER_BYTE);
+    return LFS_ERR_OK;
+}
+
+// NOR flash: programming can only clear bits.
+int LittleFSFS::flashProg(const lfs_config *c, lfs_block_t block, lfs_off_t off, const void *buffer, lfs_size_t size) {
+    LittleFSFS    *fs  = (LittleFSFS *)c->context;
+    uint8_t       *dst = &fs->_flash[(size_t)block * BLOCK_SIZE + off];
+    const uint8_t *src = (const uint8_t *)buffer;
+    for (lfs_size_t i = 0; i < size; i++) dst[i] &= src[i];
+    fs->_stats.progs++;
+    fs->_stats.progBytes += size;
+    fs->charge(FLASH_BENCH_CALL_NS + (uint64_t)size * FLASH_BENCH_PROG_NS_PER_BYTE);
+    return LFS_ERR_OK;
+}
+
+int LittleFSFS::flashErase(const lfs_config *c, lfs_block_t block) {
+    LittleFSFS *fs = (LittleFSFS *)c->context;
+    memset(&fs->_flash[(size_t)block * BLOCK_SIZE], 0xFF, BLOCK_SIZE);
+    fs->_stats.erases++;
+    fs->charge(FLASH_BENCH_CALL_NS + (uint64_t)FLASH_BENCH_ERASE_US * 1000);
+    return LFS_ERR_OK;
+}
+
+int LittleFSFS::flashSync(const lfs_config *) {
+    return LFS_ERR_OK;
+}
+
+// esp_littlefs's lfs_config, with the profile's values.
+void LittleFSFS::configure() {
+    if (_flash.empty()) _flash.assign(FLASH_BENCH_PARTITION_BYTES, 0xFF);
+    memset(&_cfg, 0, sizeof(_cfg));
+    _cfg.context        = this;
+    _cfg.read           = flashRead;
+    _cfg.prog           = flashProg;
+    _cfg.erase          = flashErase;
+    _cfg.sync           = flashSync;
+    _cfg.read_size      = _profile.readSize;
+    _cfg.prog_size      = _profile.progSize;
+    _cfg.block_size     = BLOCK_SIZE;
+    _cfg.block_count    = _flash.size() / BLOCK_SIZE;
+    _cfg.cache_size     = _profile.cacheSize;
+    _cfg.lookahead_size = _profile.lookaheadSize;
+    _cfg.block_cycles   = _profile.blockCycles;
+}
+
+// ── Filesystem ────────────────────────────────────────────────────────────────
+
+bool LittleFSFS::begin(bool formatOnFail) {
+    if (_mounted) return true;
+    configure();
+    int err = lfs_mount(&_lfs, &_cfg);
+    if (err && formatOnFail && lfs_format(&_lfs, &_cfg) == LFS_ERR_OK) err = lfs_mount(&_lfs, &_cfg);
+    _mounted = err == LFS_ERR_OK;
+    return _mounted;
+}
+
+void LittleFSFS::end() {
+    if (_mounted) lfs_unmount(&_lfs);
+    _mounted = false;
+}
+
+// Like esp_littlefs, a mounted filesystem is mounted again after formatting.
+bool LittleFSFS::format() {
+    bool wasMounted = _mounted;
+    end();
+    configure();
+    if (lfs_format(&_lfs, &_cfg) != LFS_ERR_OK) return false;
+    return !wasMounted || begin();
+}
+
+size_t LittleFSFS::totalBytes() {
+    return (size_t)_cfg.block_count * BLOCK_SIZE;
+}
+
+size_t LittleFSFS::usedBytes() {
+    lfs_ssize_t blocks = _mounted ? lfs_fs_size(&_lfs) : 0;
+    return blocks > 0 ? (size_t)blocks * BLOCK_SIZE : 0;
+}
+
+bool LittleFSFS::exists(const char *path) {
+    struct lfs_info info;
+    return _mounted && lfs_stat(&_lfs, path, &info) == LFS_ERR_OK;
+}
+
+bool LittleFSFS::mkdir(const char *path) {
+    return _mounted && lfs_mkdir(&_lfs, path) == LFS_ERR_OK;
+}
+
+bool LittleFSFS::rmdir(const char *path) {
+    return _mounted && lfs_remove(&_lfs, path) == LFS_ERR_OK;
+}
+
+bool LittleFSFS::remove(const char *path) {
+    return _mounted && lfs_remove(&_lfs, path) == LFS_ERR_OK;
+}
+
+bool LittleFSFS::rename(const char *from, const char *to) {
+    return _mounted && lfs_rename(&_lfs, from, to) == LFS_ERR_OK;
+}
+
+// ── Files ─────────────────────────────────────────────────────────────────────
+
+struct File::Handle {
+    lfs_t     *lfs;
+    lfs_file_t file;
+    ~Handle() { if (lfs) lfs_file_close(lfs, &file); }
+};
+
+// "r", "w" or "a", as fopen() takes them. <create> makes the missing parent
+// directories, as the Arduino library does.
+File LittleFSFS::open(const char *path, const char *mode, bool create) {
+    File f;
+    if (!_mounted) return f;
+
+    int flags = mode[0] == 'w' ? LFS_O_WRONLY | LFS_O_CREAT | LFS_O_TRUNC
+              : mode[0] == 'a' ? LFS_O_WRONLY | LFS_O_CREAT | LFS_O_APPEND
+              :                  LFS_O_RDONLY;
+    if (create) {
+        char parent[LFS_NAME_MAX + 1];
+        for (const char *slash = strchr(path + 1, '/'); slash; slash = strchr(slash + 1, '/')) {
+            size_t len = min<size_t>(slash - path, sizeof(parent) - 1);
+            memcpy(parent, path, len);
+            parent[len] = '\0';
+            lfs_mkdir(&_lfs, parent);  // LFS_ERR_EXIST when already there
+        }
+    }
+
+    std::shared_ptr<File::Handle> h(new File::Handle);
+    h->lfs = &_lfs;
+    if (lfs_file_open(&_lfs, &h->file, path, flags) != LFS_ERR_OK) {
+        h->lfs = nullptr;
+        return f;
+    }
+    f._handle = h;
+    return f;
+}
+
+size_t File::write(const uint8_t *buf, size_t size) {
+    if (!_handle) return 0;
+    lfs_ssize_t n = lfs_file_write(_handle->lfs, &_handle->file, buf, size);
+    return n > 0 ? (size_t)n : 0;
+}
+
+size_t File::read(uint8_t *buf, size_t size) {
+    if (!_handle) return 0;
+    lfs_ssize_t n = lfs_file_read(_handle->lfs, &_handle->file, buf, size);
+    return n > 0 ? (size_t)n : 0;
+}
+
+size_t File::size() const {
+    if (!_handle) return 0;
+    lfs_soff_t n = lfs_file_size(_handle->lfs, &_handle->file);
+    return n > 0 ? (size_t)n : 0;
+}
+
+#endif
@@ -0,0 +1,119 @@
+// LittleFS.h — host stand-in for the Arduino-ESP32 LittleFS library, used by
+// the native_flash envs only (see FlashBenchMain.cpp). Mirrors the calls
+// FlashBench.cpp makes, so it builds unchanged. Underneath is the real
+// littlefs core, configured as esp_littlefs configures it, on an in-memory
+// NOR flash the size of the board's LittleFS partition: programming only
+// clears bits, erasing sets a 4 KB block back to 0xFF. Each read, program and
+// erase call is charged what the esp_partition call costs on the device
+// (FLASH_BENCH_* in config.h), so a profile change shows up as modeled time.
+//
+// Only what the bench uses is modeled: no directory iteration, no seek.
+
+#ifndef HOST_LITTLEFS_H
+#define HOST_LITTLEFS_H
+
+#include <Arduino.h>
+#include <lfs.h>
+#include <memory>
+#include <vector>
+#include "config.h"
+
+// esp_littlefs defaults, for a build without the platformio.ini profile.
+#ifndef CONFIG_LITTLEFS_READ_SIZE
+#define CONFIG_LITTLEFS_READ_SIZE 128
+#endif
+#ifndef CONFIG_LITTLEFS_WRITE_SIZE
+#define CONFIG_LITTLEFS_WRITE_SIZE 128
+#endif
+#ifndef CONFIG_LITTLEFS_CACHE_SIZE
+#define CONFIG_LITTLEFS_CACHE_SIZE 512
+#endif
+#ifndef CONFIG_LITTLEFS_LOOKAHEAD_SIZE
+#define CONFIG_LITTLEFS_LOOKAHEAD_SIZE 128
+#endif
+#ifndef CONFIG_LITTLEFS_BLOCK_CYCLES
+#define CONFIG_LITTLEFS_BLOCK_CYCLES 512
+#endif
+
+// Mount settings: the sdkconfig options esp_littlefs passes to littlefs.
+struct LittleFSProfile {
+    uint32_t readSize      = CONFIG_LITTLEFS_READ_SIZE;
+    uint32_t progSize      = CONFIG_LITTLEFS_WRITE_SIZE;
+    uint32_t cacheSize     = CONFIG_LITTLEFS_CACHE_SIZE;
+    uint32_t lookaheadSize = CONFIG_LITTLEFS_LOOKAHEAD_SIZE;
+    int32_t  blockCycles   = CONFIG_LITTLEFS_BLOCK_CYCLES;
+};
+
+// Modeled flash traffic since the last resetStats().
+struct FlashStats {
+    uint64_t ns        = 0;
+    uint32_t reads     = 0;
+    uint32_t progs     = 0;
+    uint32_t erases    = 0;
+    uint64_t readBytes = 0;
+    uint64_t progBytes = 0;
+};
+
+class File {
+public:
+    File() {}
+
+    operator bool() const { return _handle != nullptr; }
+    size_t write(const uint8_t *buf, size_t size);
+    size_t read(uint8_t *buf, size_t size);
+    size_t size() const;
+    void   close() { _handle.reset(); }
+
+private:
+    friend class LittleFSFS;
+    struct Handle;
+    std::shared_ptr<Handle> _handle;
+};
+
+class LittleFSFS {
+public:
+    static const uint32_t BLOCK_SIZE = 4096;  // Flash sector, as in esp_littlefs
+
+    bool   begin(bool formatOnFail = false);
+    void   end();
+    bool   format();
+    size_t totalBytes();
+    size_t usedBytes();
+
+    File open(const char *path, const char *mode = "r", bool create = false);
+    bool exists(const char *path);
+    bool mkdir(const char *path);
+    bool rmdir(const char *path);
+    bool remove(const char *path);
+    bool rename(const char *from, const char *to);
+
+    // Stand-in only.
+    void              setProfile(const LittleFSProfile &p) { _profile = p; }
+    const LittleFSProfile &profile() const { return _profile; }
+    const FlashStats &stats() const { return _stats; }
+    void              resetStats() { _stats = FlashStats(); }
+    uint32_t          modeledMicros() const { return (uint32_t)(_totalNs / 1000); }
+
+private:
+    friend class File;
+
+    void configure();
+    void charge(uint64_t ns);
+
+    static int flashRead(const lfs_config *c, lfs_block_t block, lfs_off_t off, void *buffer, lfs_size_t size);
+    static int flashProg(const lfs_config *c, lfs_block_t block, lfs_off_t off, const void *buffer, lfs_size_t size);
+    static int flashErase(const lfs_config *c, lfs_block_t block);
+    static int flashSync(const lfs_config *c);
+
+    LittleFSProfile      _profile;
+    lfs_config           _cfg;
+    lfs_t                _lfs;
+    bool                 _mounted = false;
+    std::vector<uint8_t> _flash;
+    FlashStats           _stats;
+    uint64_t             _totalNs = 0;  // Never reset: the bench's clock
+};
+
+extern LittleFSFS LittleFS;
+
+#endif
@@ -0,0 +1,101 @@
+// PngWriter.cpp — minimal PNG output for the render bench (host build only).
+
+#ifdef NATIVE_RENDER_BENCH
+
+#include "PngWriter.h"
+#include <cstdio>
+#include <vector>
+
+// ── Checksums ─────────────────────────────────────────────────────────────────
+
+static uint32_t crc32(uint32_t crc, const uint8_t *data, size_t len) {
+    static uint32_t table[256];
+    if (!table[1]) {
+        for (uint32_t n = 0; n < 256; n++) {
+            uint32_t c = n;
+            for (int k = 0; k < 8; k++) c = c & 1 ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            table[n] = c;
+        }
+    }
+    crc = ~crc;
+    for (size_t i = 0; i < len; i++) crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+static uint32_t adler32(const uint8_t *data, size_t len) {
+    uint32_t a = 1, b = 0;
+    for (size_t i = 0; i < len; i++) {
+        a = (a + data[i]) % 65521;
+        b = (b + a) % 65521;
+    }
+    return b << 16 | a;
+}
+
+// ── Writer ────────────────────────────────────────────────────────────────────
+
+static void put32(std::vector<uint8_t> &out, uint32_t v) {
+    out.push_back(v >> 24);
+    out.push_back(v >> 16);
+    out.push_back(v >> 8);
+    out.push_back(v);
+}
+
+// Length, type, data, CRC over type and data.
+static void writeChunk(FILE *f, const char *type, const std::vector<uint8_t> &data) {
+    std::vector<uint8_t> chunk;
+    put32(chunk, data.size());
+    chunk.insert(chunk.end(), type, type + 4);
+    chunk.insert(chunk.end(), data.begin(), data.end());
+    put32(chunk, crc32(0, chunk.data() + 4, chunk.size() - 4));
+    fwrite(chunk.data(), 1, chunk.size(), f);
+}
+
+bool writePng(const char *path, const uint16_t *pixels, int w, int h) {
+    // Filter type 0 per row, then RGB888 expanded from RGB565.
+    std::vector<uint8_t> raw;
+    raw.reserve((size_t)h * (1 + w * 3));
+    for (int y = 0; y < h; y++) {
+        raw.push_back(0);
+        for (int x = 0; x < w; x++) {
+            uint16_t p = pixels[(size_t)y * w + x];
+            uint8_t  r = p >> 11, g = (p >> 5) & 0x3F, b = p & 0x1F;
+            raw.push_back(r << 3 | r >> 2);
+            raw.push_back(g << 2 | g >> 4);
+            raw.push_back(b << 3 | b >> 2);
+        }
+    }
+
+    // zlib stream of stored blocks (at most 65535 bytes each).
+    std::vector<uint8_t> idat = {0x78, 0x01};
+    size_t pos = 0;
+    do {
+        size_t len  = raw.size() - pos < 65535 ? raw.size() - pos : 65535;
+        bool   last = pos + len == raw.size();
+        idat.push_back(last ? 1 : 0);
+        idat.push_back(len & 0xFF);
+        idat.push_back(len >> 8);
+        idat.push_back(~len & 0xFF);
+        idat.push_back((~len >> 8) & 0xFF);
+        idat.insert(idat.end(), raw.begin() + pos, raw.begin() + pos + len);
+        pos += len;
+    } while (pos < raw.size());
+    put32(idat, adler32(raw.data(), raw.size()));
+
+    std::vector<uint8_t> ihdr;
+    put32(ihdr, w);
+    put32(ihdr, h);
+    ihdr.insert(ihdr.end(), {8, 2, 0, 0, 0});  // 8-bit RGB, no interlace
+
+    FILE *f = fopen(path, "wb");
+    if (!f) return false;
+    static const uint8_t SIGNATURE[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    fwrite(SIGNATURE, 1, sizeof(SIGNATURE), f);
+    writeChunk(f, "IHDR", ihdr);
+    writeChunk(f, "IDAT", idat);
+    writeChunk(f, "IEND", {});
+    bool ok = !ferror(f);
+    fclose(f);
+    return ok;
+}
+
+#endif
@@ -0,0 +1,15 @@
+// PngWriter.h — minimal PNG output for the render bench (host build only).
+// Writes an RGB565 framebuffer as an 8-bit RGB PNG with stored (uncompressed)
+// deflate blocks, so the bench needs no zlib or libpng.
+
+#ifndef PNG_WRITER_H
+#define PNG_WRITER_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Write <w>×<h> row-major RGB565 pixels to <path>. Returns false if the file
+// cannot be written.
+bool writePng(const char *path, const uint16_t *pixels, int w, int h);
+
+#endif
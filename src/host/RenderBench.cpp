@@ -0,0 +1,216 @@
+// RenderBench.cpp — host-side render bench (native_render envs only).
+// Replays recorded frames through the firmware's own output path: tjpgd
+// decodes each JPEG and hands its blocks to tft_output() (Display.cpp,
+// built unchanged), which blits them into the Arduino_GFX stand-in. The
+// stand-in models the panel bus (see Arduino_GFX_Library.h), so the report
+// gives, per frame:
+//   - decode time on the host CPU. Only useful for comparing changes; an
+//     ESP32 is one to two orders of magnitude slower.
+//   - modeled transfer time, bus transactions and bytes for the board's
+//     panel (GC9A01 over SPI, or SPD2010 over QSPI with BOARD_WAVESHARE).
+// Last, the blocks of the final frame are replayed straight into
+// tft_output() to time the per-block cost of the output path on its own:
+// build with -DDISPLAY_DIRECT_BLIT=false to compare against the virtual
+// Arduino_GFX path. With a second argument the panel contents after each
+// frame are written there as PNG, to check that an output-path change still
+// draws the same pixels.
+//
+//   pio run -e native_render
+//   .pio/build/native_render/program <dir of .jpg frames> [png dir]
+
+#ifdef NATIVE_RENDER_BENCH
+
+#include "config.h"
+#include "Display.h"
+#include "PngWriter.h"
+#include <tjpgd.h>
+#include <algorithm>
+#include <dirent.h>
+#include <string>
+#include <vector>
+
+extern Arduino_DataBus *_bus;
+
+// ── Decoding ──────────────────────────────────────────────────────────────────
+
+struct MemSource {
+    const uint8_t *data;
+    size_t         size;
+    size_t         pos;
+};
+
+static size_t memInput(JDEC *jd, uint8_t *buf, size_t len) {
+    MemSource *src = (MemSource *)jd->device;
+    len = min(len, src->size - src->pos);
+    if (buf) memcpy(buf, src->data + src->pos, len);
+    src->pos += len;
+    return len;
+}
+
+static int memOutput(JDEC *, void *bitmap, JRECT *rect) {
+    return tft_output(rect->left, rect->top, rect->right - rect->left + 1,
+                      rect->bottom - rect->top + 1, (uint16_t *)bitmap) ? 1 : 0;
+}
+
+// Same call TJpgDec::drawJpg() makes: whole image at (0, 0), no scaling,
+// blocks in the decoder's native byte order. The work area covers every
+// JD_FASTDECODE level.
+static bool drawFrame(const std::vector<uint8_t> &jpeg, uint16_t *w, uint16_t *h) {
+    static uint8_t work[16384];
+    MemSource      src = {jpeg.data(), jpeg.size(), 0};
+    JDEC           jd;
+    if (jd_prepare(&jd, memInput, work, sizeof(work), &src) != JDR_OK) return false;
+    *w = jd.width;
+    *h = jd.height;
+    return jd_decomp(&jd, memOutput, 0) == JDR_OK;
+}
+
+// ── Block replay ──────────────────────────────────────────────────────────────
+
+struct Tile {
+    int16_t  x, y;
+    uint16_t w, h;
+    size_t   offset;  // into _tilePixels
+};
+
+static std::vector<Tile>     _tiles;
+static std::vector<uint16_t> _tilePixels;
+
+// Tile tap: keep a copy of every block, since the decoder reuses its buffer.
+static void recordTile(int16_t x, int16_t y, uint16_t w, uint16_t h, const uint16_t *bitmap) {
+    _tiles.push_back({x, y, w, h, _tilePixels.size()});
+    _tilePixels.insert(_tilePixels.end(), bitmap, bitmap + (size_t)w * h);
+}
+
+// Nanoseconds per tft_output() call, averaged over <rounds> replays.
+static double replayTiles(int rounds) {
+    using namespace std::chrono;
+    const steady_clock::time_point start = steady_clock::now();
+    for (int r = 0; r < rounds; r++)
+        for (const Tile &t : _tiles)
+            tft_output(t.x, t.y, t.w, t.h, &_tilePixels[t.offset]);
+    const double ns = duration_cast<nanoseconds>(steady_clock::now() - start).count();
+    return ns / ((double)rounds * _tiles.size());
+}
+
+// ── Frames ────────────────────────────────────────────────────────────────────
+
+static std::vector<std::string> listFrames(const char *dir) {
+    std::vector<std::string> names;
+    if (DIR *d = opendir(dir)) {
+        while (dirent *e = readdir(d)) {
+            std::string name = e->d_name;
+            if (name.size() > 4 && name.compare(name.size() - 4, 4, ".jpg") == 0) names.push_back(name);
+        }
+        closedir(d);
+    }
+    std::sort(names.begin(), names.end());
+    return names;
+}
+
+static bool readFile(const std::string &path, std::vector<uint8_t> &out) {
+    FILE *f = fopen(path.c_str(), "rb");
+    if (!f) return false;
+    fseek(f, 0, SEEK_END);
+    out.resize(ftell(f));
+    fseek(f, 0, SEEK_SET);
+    bool ok = fread(out.data(), 1, out.size(), f) == out.size();
+    fclose(f);
+    return ok;
+}
+
+// ── Bench ─────────────────────────────────────────────────────────────────────
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s <dir of .jpg frames> [png output dir]\n", argv[0]);
+        return 2;
+    }
+    const char *pngDir = argc > 2 ? argv[2] : nullptr;
+    std::vector<std::string> frames = listFrames(argv[1]);
+    if (frames.empty()) {
+        fprintf(stderr, "no .jpg frames in %s\n", argv[1]);
+        return 1;
+    }
+
+    initDisplay();
+
+    // The floor for a full frame: one window, every pixel sent once. Tile
+    // overhead is what a decode costs above this.
+    _bus->resetStats();
+    gfx->fillScreen(0x0000);
+    const BusStats fullFrame = _bus->stats();
+
+    printf("Render bench: %d×%d over %s, %zu frame(s) × %d pass(es)\n",
+           DISPLAY_WIDTH, DISPLAY_HEIGHT, _bus->name(), frames.size(), RENDER_BENCH_PASSES);
+    printf("Full-frame floor: %.2f ms, %u transactions\n\n", fullFrame.ns / 1e6, fullFrame.transactions);
+    printf("%-34s %8s %10s %10s %8s %9s\n", "frame", "bytes", "decode_ms", "bus_ms", "txns", "bus_kB");
+
+    double   decodeMsTotal = 0, busMsTotal = 0;
+    uint64_t txnTotal = 0;
+    int      drawn = 0, failed = 0;
+
+    for (const std::string &name : frames) {
+        std::vector<uint8_t> jpeg;
+        if (!readFile(std::string(argv[1]) + "/" + name, jpeg)) {
+            failed++;
+            continue;
+        }
+
+        double   decodeMs = 0;
+        BusStats bus;
+        uint16_t w = 0, h = 0;
+        bool     ok = true;
+        for (int pass = 0; pass < RENDER_BENCH_PASSES && ok; pass++) {
+            _bus->resetStats();
+            takeBlitMicros();
+            uint32_t start = micros();
+            ok = drawFrame(jpeg, &w, &h);
+            uint32_t total = micros() - start;
+            decodeMs += (total - takeBlitMicros()) / 1000.0;
+            bus = _bus->stats();  // identical every pass
+        }
+        if (!ok) {
+            printf("%-34s %8zu   decode failed\n", name.c_str(), jpeg.size());
+            failed++;
+            continue;
+        }
+        decodeMs /= RENDER_BENCH_PASSES;
+        if (w != DISPLAY_WIDTH || h != DISPLAY_HEIGHT)
+            fprintf(stderr, "%s is %u×%u, not %d×%d\n", name.c_str(), w, h, DISPLAY_WIDTH, DISPLAY_HEIGHT);
+
+        printf("%-34s %8zu %10.2f %10.2f %8u %9.1f\n", name.c_str(), jpeg.size(), decodeMs,
+               bus.ns / 1e6, bus.transactions, bus.bytes / 1024.0);
+        // One more, untimed, decode to capture the blocks for the replay.
+        _tiles.clear();
+        _tilePixels.clear();
+        setTileTap(recordTile);
+        drawFrame(jpeg, &w, &h);
+        setTileTap(nullptr);
+
+        decodeMsTotal += decodeMs;
+        busMsTotal    += bus.ns / 1e6;
+        txnTotal      += bus.transactions;
+        drawn++;
+
+        if (pngDir) {
+            std::string png = std::string(pngDir) + "/" + name.substr(0, name.size() - 4) + ".png";
+            if (!writePng(png.c_str(), _bus->gram(), gfx->width(), gfx->height()))
+                fprintf(stderr, "cannot write %s\n", png.c_str());
+        }
+    }
+
+    if (drawn == 0) return 1;
+    const double busMs = busMsTotal / drawn;
+    printf("\nAverage over %d frame(s)%s:\n", drawn, failed ? " (some failed)" : "");
+    printf("  decode (host)   %8.2f ms\n", decodeMsTotal / drawn);
+    printf("  bus (modeled)   %8.2f ms  %llu transactions, %.0f%% above the full-frame floor\n", busMs,
+           (unsigned long long)(txnTotal / drawn), fullFrame.ns ? 100.0 * (busMs * 1e6 - fullFrame.ns) / fullFrame.ns : 0.0);
+    printf("  bus-bound FPS   %8.1f\n", busMs > 0 ? 1000.0 / busMs : 0.0);
+    printf("  blit call (host) %7.1f ns per block, %zu blocks, %s path\n",
+           replayTiles(RENDER_BENCH_REPLAYS), _tiles.size(),
+           DISPLAY_DIRECT_BLIT ? "direct" : "Arduino_GFX");
+    return failed ? 1 : 0;
+}
+
+#endif
@@ -0,0 +1,118 @@
+// RleCodecTest.cpp — host test for the RLE frame codec (native_rle env only).
+// Drives RleEncoder the way Playback does, with MCU-sized tiles from a
+// synthetic frame, and expands the result through drawRleFrame() into the
+// panel stand-in. Built with a small RLE_MAX_INTERNAL_BYTES (the host has no
+// PSRAM), so a noisy frame outgrows the encoder and must be abandoned cleanly.
+// Exits non-zero if any check fails.
+//
+//   pio run -e native_rle && .pio/build/native_rle/program
+
+#ifdef NATIVE_RLE_TEST
+
+#include "config.h"
+#include "Display.h"
+#include "FrameCodec.h"
+#include <vector>
+
+extern Arduino_DataBus *_bus;
+
+static const int TILE = 16;  // One JPEG MCU, as TJpgDec hands them over
+
+static int _failures = 0;
+
+static void check(bool ok, const char *what) {
+    printf("%-52s %s\n", what, ok ? "ok" : "FAILED");
+    if (!ok) _failures++;
+}
+
+// Black space with a square of <side> pixels in the middle. <noisy> fills it
+// with pixels that never repeat (all literals); otherwise with bands of one
+// colour (long runs). Every value is well clear of RLE_BLACK_LEVEL.
+static std::vector<uint16_t> makeFrame(int side, bool noisy) {
+    std::vector<uint16_t> px((size_t)DISPLAY_WIDTH * DISPLAY_HEIGHT, 0);
+    const int x0 = (DISPLAY_WIDTH - side) / 2, y0 = (DISPLAY_HEIGHT - side) / 2;
+    uint32_t  seed = 12345;
+    for (int y = y0; y < y0 + side; y++) {
+        for (int x = x0; x < x0 + side; x++) {
+            seed = seed * 1103515245u + 12345u;
+            px[(size_t)y * DISPLAY_WIDTH + x] = noisy ? 0x8000 | (seed >> 17) : 0xF800 | (y / 8);
+        }
+    }
+    return px;
+}
+
+// Noise across the bottom rows only, just enough of it to cross
+// RLE_MAX_INTERNAL_BYTES inside the last band, i.e. during finish().
+static std::vector<uint16_t> makeNoisyTail() {
+    std::vector<uint16_t> px((size_t)DISPLAY_WIDTH * DISPLAY_HEIGHT, 0);
+    const int rows = min(DISPLAY_HEIGHT, RLE_MAX_INTERNAL_BYTES / (2 * DISPLAY_WIDTH) + 1);
+    uint32_t  seed = 54321;
+    for (size_t i = (size_t)(DISPLAY_HEIGHT - rows) * DISPLAY_WIDTH; i < px.size(); i++) {
+        seed  = seed * 1103515245u + 12345u;
+        px[i] = 0x8000 | (seed >> 17);
+    }
+    return px;
+}
+
+// Feed <frame> to the encoder in MCU order, as the JPEG decoder's tile tap does.
+static bool encode(RleEncoder &enc, const std::vector<uint16_t> &frame, uint8_t **data, size_t *size) {
+    if (!enc.begin(DISPLAY_WIDTH, DISPLAY_HEIGHT)) return false;
+    uint16_t tile[TILE * TILE];
+    for (int y = 0; y < DISPLAY_HEIGHT; y += TILE) {
+        for (int x = 0; x < DISPLAY_WIDTH; x += TILE) {
+            int w = min(TILE, DISPLAY_WIDTH - x), h = min(TILE, DISPLAY_HEIGHT - y);
+            for (int row = 0; row < h; row++)
+                memcpy(tile + row * w, &frame[(size_t)(y + row) * DISPLAY_WIDTH + x], w * 2);
+            enc.addTile(x, y, w, h, tile);
+        }
+    }
+    return enc.finish(data, size);
+}
+
+static bool panelShows(const std::vector<uint16_t> &frame) {
+    return memcmp(_bus->gram(), frame.data(), frame.size() * 2) == 0;
+}
+
+int main() {
+    initDisplay();
+    RleEncoder enc;
+    uint8_t   *data = nullptr;
+    size_t     size = 0;
+    uint32_t   blitUs = 0;
+
+    printf("RLE codec, %dx%d, RLE_MAX_INTERNAL_BYTES %d\n\n", DISPLAY_WIDTH, DISPLAY_HEIGHT,
+           RLE_MAX_INTERNAL_BYTES);
+
+    // A frame that does not compress below the cap is abandoned, with a
+    // literal and a run still open: first while tiles arrive, then while
+    // finish() flushes the last band.
+    std::vector<uint16_t> noisy = makeFrame(DISPLAY_WIDTH * 3 / 4, true);
+    check(!encode(enc, noisy, &data, &size), "noisy frame over the cap is abandoned");
+    check(!enc.active(), "encoder released its buffer");
+    std::vector<uint16_t> tail = makeNoisyTail();
+    check(!encode(enc, tail, &data, &size), "cap crossed in the last band is abandoned");
+    check(!enc.active(), "encoder released its buffer");
+
+    // The encoder is reusable after an abort, and its output round-trips.
+    std::vector<uint16_t> calm = makeFrame(DISPLAY_WIDTH / 2, false);
+    bool encoded = encode(enc, calm, &data, &size);
+    check(encoded, "banded frame encodes after the abort");
+    if (encoded) {
+        check(size <= RLE_MAX_INTERNAL_BYTES, "encoding fits within the cap");
+        check(verifyRleFrame(data, size), "header and payload CRC verify");
+        check(drawRleFrame(data, size, &blitUs) && panelShows(calm), "expands to the source pixels");
+
+        // A truncated or corrupted stream must fail before its first band
+        // reaches the panel, leaving the previous frame on screen.
+        check(!drawRleFrame(data, size - 2, &blitUs) && panelShows(calm), "truncated frame draws nothing");
+        uint16_t token = 0x7FFF;  // a literal whose pixels run past the end
+        memcpy(data + sizeof(RleHeader), &token, 2);
+        check(!drawRleFrame(data, size, &blitUs) && panelShows(calm), "overlong literal draws nothing");
+        free(data);
+    }
+
+    printf("\n%s\n", _failures ? "FAILED" : "All checks passed");
+    return _failures ? 1 : 0;
+}
+
+#endif
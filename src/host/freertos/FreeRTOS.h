@@ -0,0 +1,13 @@
+// freertos/FreeRTOS.h — host shim for the native_render and native_rle envs.
+// Both are single-threaded, so only the types and constants Display.cpp uses
+// exist.
+
+#ifndef HOST_FREERTOS_H
+#define HOST_FREERTOS_H
+
+#include <cstdint>
+
+typedef uint32_t TickType_t;
+#define portMAX_DELAY ((TickType_t)0xFFFFFFFF)
+
+#endif
@@ -0,0 +1,18 @@
+// freertos/semphr.h — host shim for the native_render and native_rle envs.
+// Locks are no-ops because nothing else runs beside the program.
+
+#ifndef HOST_SEMPHR_H
+#define HOST_SEMPHR_H
+
+#include "FreeRTOS.h"
+
+typedef void *SemaphoreHandle_t;
+
+inline SemaphoreHandle_t xSemaphoreCreateRecursiveMutex() {
+    static int token;
+    return &token;
+}
+inline int xSemaphoreTakeRecursive(SemaphoreHandle_t, TickType_t) { return 1; }
+inline int xSemaphoreGiveRecursive(SemaphoreHandle_t) { return 1; }
+
+#endif
@@ -3,24 +3,32 @@
 // Fetches GOES / ElektroL satellite imagery via ImageKit.io, caches it on
 // LittleFS, and animates the last 24 hours on a round TFT display.
 //
-// Boot sequence: display → WiFi → NTP → cache → loop
-// Loop:          download latest frame → draw → animate 24 h → wait
+// Boot sequence: display → WiFi → NTP → cache → playback → sync task
+//                (each phase is timed; see Metrics::bootPhase)
+// Loop:          playback tick (touch + next frame); downloads run on the sync task
 
 #include <Arduino.h>
 #include <WiFi.h>
-#include <TJpg_Decoder.h>
 #include <time.h>
 #include <esp_task_wdt.h>
 
 #include "config.h"
 #include "Display.h"
+#include "Metrics.h"
+#include "JpegDecoder.h"
 #include "WiFiManager.h"
 #include "ImageCache.h"
 #include "ImageDownloader.h"
+#include "MissCache.h"
+#include "Playback.h"
+#include "Prefetch.h"
+#include "NetworkBench.h"
+#include "DecoderBench.h"
+#include "FlashBench.h"
 
 // ── Shared image buffer ───────────────────────────────────────────────────────
-// Owned here; extern'd in ImageDownloader.h so both the downloader and cache
-// can read and write the same allocation without passing pointers everywhere.
+// Owned here; extern'd in ImageCache.h. loadImage() fills it and the playback
+// engine decodes from it — the sync task downloads into a buffer of its own.
 uint8_t *imageBuffer = nullptr;
 size_t   imageSize   = 0;
 
@@ -58,16 +66,26 @@ void setup() {
 
     if (DEBUG_ENABLED) Serial.println("\nFlatEarth display starting...");
     printSystemInfo();
+    metrics.bootPhase("startup");
 
     initDisplay();
     showStatus("FlatEarth starting...");
+    metrics.bootPhase("display");
 
-    // Wire the JPEG decoder to the display callback. setSwapBytes(false) because
-    // Arduino_GFX expects native-endian (little-endian) RGB565.
-    TJpgDec.setSwapBytes(false);
-    TJpgDec.setCallback(tft_output);
+    // Wire the JPEG decoder backend to the display callback.
+    if (!jpegDecoder.begin()) showStatus("Decoder FAILED", 0xF800);
+    if (DEBUG_ENABLED) Serial.printf("JPEG decoder: %s\n", jpegDecoder.name());
+    metrics.bootPhase("decoder");
+
+#ifdef DECODER_BENCH
+    runDecoderBench();  // decodes frames already in the cache; does not return
+#endif
+#ifdef FLASH_BENCH
+    runFlashBench();  // formats the cache and benchmarks LittleFS; does not return
+#endif
 
     setupWiFi();
+    metrics.bootPhase("wifi");
 
     // Synchronise the RTC via NTP. Block until the time is valid so that image
     // URL timestamps are correct from the very first download.
@@ -76,34 +94,38 @@ void setup() {
     struct tm t;
     while (!getLocalTime(&t)) delay(500);
     showStatus("Time OK", 0x07E0);
+    metrics.bootPhase("ntp");
 
+#ifdef NETWORK_BENCH
+    runNetworkBench();  // formats the cache and runs the bench; does not return
+#endif
+
+    // cache.begin() closes its own cache_mount, stale_purge and cache_index phases.
     showStatus("Init cache...");
-    if (cache.begin())
+    if (cache.begin()) {
+        missCache.begin();
+        metrics.bootPhase("miss_cache");
+        prefetcher.begin();
+        startNetworkServices();
         showStatus("Cache OK", 0x07E0);
-    else
+    } else {
+        // Nothing to play and nowhere to download to: leave the error on
+        // screen rather than running playback and sync against no cache.
         showStatus("Cache FAILED", 0xF800);
-}
-
-void loop() {
-    if (WiFi.status() != WL_CONNECTED) {
-        if (DEBUG_ENABLED) Serial.println("WiFi lost, reconnecting...");
-        setupWiFi();
+        metrics.printBootReport();
         return;
     }
 
-    // Fetch and display the most recent satellite image.
-    String ts = ImageDownloader::getFormattedTime();
-    if (ImageDownloader::downloadImage(ts)) {
-        if (DEBUG_ENABLED) Serial.println("Drawing latest frame...");
-        TJpgDec.drawJpg(0, 0, imageBuffer, imageSize);
-    }
-
-    // Play back the last 24 hours as an animation.
-    ImageDownloader::showLastXHours();
-
-    // Print cache health to Serial after every full animation cycle so the user
-    // can see how full the cache is and whether quality settings need tuning.
-    cache.printStats();
+    // Show the newest cached frame immediately, then start filling the cache
+    // in the background.
+    player.begin();
+    metrics.bootPhase("first_frame");
+    ImageDownloader::startSync();
+    metrics.bootPhase("sync_start");
+    metrics.printBootReport();
+}
 
-    delay(UPDATE_INTERVAL_MS);
+void loop() {
+    if (cache.ready()) player.tick();
+    delay(PLAYBACK_TICK_MS);
 }
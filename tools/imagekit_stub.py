@@ -0,0 +1,289 @@
+#!/usr/bin/env python3
+"""imagekit_stub.py — local stand-in for the ImageKit/NOAA/EUMETSAT path.
+
+Serves fixture JPEGs for every URL shape ImageDownloader::constructUrl()
+generates, with knobs for the network conditions that are hard to reproduce
+against the real CDN:
+
+  GOES:     /<id>/GOES/tr:w-..,h-..,q-../GOES19/ABI/FD/GEOCOLOR/<ts>_GOES19-ABI-FD-GEOCOLOR-1808x1808.jpg
+  ElektroL: /<id>/ElektroL/tr:.../<ts>.jpg
+  Meteosat: /<id>/Meteosat/tr:.../EUMETSAT_MSG_..._LowResolution.jpg?ik-cache-bust=<ts>
+
+Each slot's body is a fixture JPEG with the slot key written into a COM
+segment, so every slot is a distinct, valid JPEG (the device de-duplicates
+identical payloads). Meteosat requests honour If-None-Match against an ETag
+derived from the body.
+
+Usage:
+  python3 tools/imagekit_stub.py --fixtures ./fixtures --port 8080 \\
+      --latency-ms 300 --bandwidth 20000 --truncate-rate 0.05 --missing-rate 0.02
+
+Then build the device with the bench environment pointed at this host:
+  pio run -e bench_network -t upload   (edit BENCH_ENDPOINT in platformio.ini)
+
+It also answers the LAN peer endpoint a FlatEarth unit serves (PeerCache.h):
+
+  /frame?sat=<SATTYPE_NAME>&ts=<ts>&w=<w>&h=<h>&q=<q>
+
+with the same tagged body the origin URL for that slot returns, plus the
+X-Frame-Hash the device checks. With --advertise the stub registers itself
+over mDNS as a _flatearth._tcp peer (needs the `zeroconf` package), so a
+device on the same LAN uses it as a second unit; run two stubs on different
+ports to stand in for a small fleet. --missing / --missing-rate apply to
+/frame too, which exercises the fall-through to the next peer and ImageKit.
+
+GET /__stats returns request counters as JSON; GET /__reset clears them.
+"""
+
+import argparse
+import glob
+import hashlib
+import json
+import os
+import random
+import re
+import sys
+import socket
+import threading
+import time
+import zlib
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+from urllib.parse import parse_qs, urlparse
+
+GOES_RE = re.compile(r"/(\d{11})_GOES\d+-ABI-FD-GEOCOLOR-\d+x\d+\.jpg$")
+ELEKTRO_RE = re.compile(r"/ElektroL/.*?/(\d{8}-\d{4})\.jpg$")
+METEOSAT_RE = re.compile(r"/EUMETSAT_MSG(?:IODC)?_\w+\.jpg$")
+
+
+def slot_key(url):
+    """Return the slot key a request asks for, or None if the URL is not one
+    constructUrl() would produce."""
+    parsed = urlparse(url)
+    m = GOES_RE.search(parsed.path)
+    if m:
+        return m.group(1)
+    m = ELEKTRO_RE.search(parsed.path)
+    if m:
+        return m.group(1)
+    if METEOSAT_RE.search(parsed.path):
+        bust = parse_qs(parsed.query).get("ik-cache-bust", [""])[0]
+        return "meteosat-" + (bust or "latest")
+    return None
+
+
+def peer_key(url, args):
+    """Slot key of a /frame request, or None if it is malformed or, with
+    --advertise, asks for another satellite, size or quality than advertised
+    (a real unit answers those with 404; the device never sends them)."""
+    q = {k: v[0] for k, v in parse_qs(urlparse(url).query).items()}
+    if not all(k in q for k in ("sat", "ts", "w", "h", "q")):
+        return None
+    if args.advertise and (q["sat"] != args.advertise or int(q["w"]) != args.size or
+                           int(q["h"]) != args.size):
+        return None
+    return q["ts"]
+
+
+def advertise(args):
+    """Register this stub as a _flatearth._tcp peer. Returns the Zeroconf
+    instance to close on exit."""
+    try:
+        from zeroconf import ServiceInfo, Zeroconf
+    except ImportError:
+        sys.exit("--advertise needs the zeroconf package (pip install zeroconf)")
+    probe = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    probe.connect(("192.0.2.1", 9))  # no traffic; just picks the LAN interface
+    ip = probe.getsockname()[0]
+    probe.close()
+    name = "stub-%d" % args.port
+    info = ServiceInfo("_flatearth._tcp.local.", "%s._flatearth._tcp.local." % name,
+                       addresses=[socket.inet_aton(ip)], port=args.port,
+                       properties={"sat": args.advertise, "w": str(args.size),
+                                   "h": str(args.size), "q": str(args.quality)},
+                       server="%s.local." % name)
+    zc = Zeroconf()
+    zc.register_service(info)
+    print("Advertised %s on %s:%d as a %s peer" % (name, ip, args.port, args.advertise))
+    return zc
+
+
+def tag_jpeg(data, key):
+    """Insert a COM segment carrying <key> right after SOI."""
+    comment = ("flatearth-stub " + key).encode()
+    segment = b"\xff\xfe" + (len(comment) + 2).to_bytes(2, "big") + comment
+    return data[:2] + segment + data[2:]
+
+
+class Stats:
+    def __init__(self):
+        self.lock = threading.Lock()
+        self.reset()
+
+    def reset(self):
+        self.counts = {"requests": 0, "ok": 0, "not_modified": 0, "not_found": 0,
+                       "truncated": 0, "bad_url": 0, "bytes_sent": 0, "peer_frames": 0}
+
+    def add(self, key, n=1):
+        with self.lock:
+            self.counts[key] += n
+
+    def snapshot(self):
+        with self.lock:
+            return dict(self.counts)
+
+
+def make_handler(args, fixtures, stats):
+    rng = random.Random(args.seed)
+    rng_lock = threading.Lock()
+    missing = set(args.missing or [])
+
+    def roll(rate):
+        with rng_lock:
+            return rng.random() < rate
+
+    def spread(ms):
+        with rng_lock:
+            return ms * (2 * rng.random() - 1)
+
+    class Handler(BaseHTTPRequestHandler):
+        server_version = "FlatEarthStub/1.0"
+        protocol_version = "HTTP/1.1"  # needed for chunked responses
+
+        def log_message(self, fmt, *a):
+            if args.verbose:
+                sys.stderr.write("%s %s\n" % (self.address_string(), fmt % a))
+
+        def send_plain(self, code, text):
+            body = text.encode()
+            self.send_response(code)
+            self.send_header("Content-Type", "text/plain")
+            self.send_header("Content-Length", str(len(body)))
+            self.end_headers()
+            self.wfile.write(body)
+
+        def write_throttled(self, data):
+            """Write data respecting --bandwidth (bytes/s); 0 = unlimited."""
+            step = 1460
+            for i in range(0, len(data), step):
+                self.wfile.write(data[i:i + step])
+                self.wfile.flush()
+                if args.bandwidth:
+                    time.sleep(step / args.bandwidth)
+
+        def do_GET(self):
+            if self.path == "/__stats":
+                self.send_plain(200, json.dumps(stats.snapshot(), indent=1) + "\n")
+                return
+            if self.path == "/__reset":
+                stats.reset()
+                self.send_plain(200, "reset\n")
+                return
+
+            stats.add("requests")
+            if args.latency_ms:
+                jitter = spread(args.jitter_ms) if args.jitter_ms else 0
+                time.sleep(max(0, args.latency_ms + jitter) / 1000)
+
+            peer = urlparse(self.path).path == "/frame"
+            key = peer_key(self.path, args) if peer else slot_key(self.path)
+            if key is None:
+                stats.add("bad_url")
+                self.send_plain(400, "unrecognised URL shape\n")
+                return
+
+            if key in missing or roll(args.missing_rate):
+                stats.add("not_found")
+                self.send_plain(404, "no such slot\n")
+                return
+
+            fixture = fixtures[int(hashlib.md5(key.encode()).hexdigest(), 16) % len(fixtures)]
+            body = tag_jpeg(fixture, key)
+            etag = '"%s"' % hashlib.md5(body).hexdigest()
+
+            if key.startswith("meteosat-") and self.headers.get("If-None-Match") == etag:
+                stats.add("not_modified")
+                self.send_response(304)
+                self.send_header("ETag", etag)
+                self.end_headers()
+                return
+
+            truncate = roll(args.truncate_rate)
+            # HTTP/1.0 clients cannot receive chunked encoding; an HTTP/1.1
+            # server falls back to a close-delimited body for them.
+            http10 = self.request_version == "HTTP/1.0"
+            chunked = args.chunked and not http10
+
+            self.send_response(200)
+            self.send_header("Content-Type", "image/jpeg")
+            self.send_header("ETag", etag)
+            if peer:
+                self.send_header("X-Frame-Hash", "%08x" % zlib.crc32(body))
+            if chunked:
+                self.send_header("Transfer-Encoding", "chunked")
+            elif not args.no_length:
+                self.send_header("Content-Length", str(len(body)))
+            self.send_header("Connection", "close")
+            self.end_headers()
+
+            sent = body[: len(body) // 2] if truncate else body
+            if chunked:
+                for i in range(0, len(sent), 4096):
+                    part = sent[i:i + 4096]
+                    self.write_throttled(b"%x\r\n" % len(part) + part + b"\r\n")
+                if not truncate:
+                    self.wfile.write(b"0\r\n\r\n")
+            else:
+                self.write_throttled(sent)
+            self.close_connection = True
+
+            stats.add("bytes_sent", len(sent))
+            stats.add("truncated" if truncate else "ok")
+            if peer and not truncate:
+                stats.add("peer_frames")
+
+    return Handler
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("--fixtures", required=True, help="directory of .jpg files to serve")
+    ap.add_argument("--host", default="0.0.0.0")
+    ap.add_argument("--port", type=int, default=8080)
+    ap.add_argument("--latency-ms", type=float, default=0, help="delay before the response headers")
+    ap.add_argument("--jitter-ms", type=float, default=0, help="± random spread on --latency-ms")
+    ap.add_argument("--bandwidth", type=float, default=0, help="body rate cap in bytes/s (0 = unlimited)")
+    ap.add_argument("--chunked", action="store_true", help="chunked transfer encoding for HTTP/1.1 clients")
+    ap.add_argument("--no-length", action="store_true", help="omit Content-Length (close-delimited body)")
+    ap.add_argument("--truncate-rate", type=float, default=0, help="fraction of bodies cut off half way")
+    ap.add_argument("--missing-rate", type=float, default=0, help="fraction of slots answered with 404")
+    ap.add_argument("--missing", nargs="*", help="slot keys that always 404")
+    ap.add_argument("--advertise", metavar="SATTYPE_NAME",
+                    help="announce over mDNS as a peer unit for this satellite (e.g. GOES_EAST)")
+    ap.add_argument("--size", type=int, default=240, help="display size advertised with --advertise")
+    ap.add_argument("--quality", type=int, default=70, help="JPEG_QUALITY advertised with --advertise")
+    ap.add_argument("--seed", type=int, default=1)
+    ap.add_argument("--verbose", action="store_true")
+    args = ap.parse_args()
+
+    paths = sorted(glob.glob(os.path.join(args.fixtures, "*.jpg")))
+    if not paths:
+        sys.exit("no .jpg fixtures in %s" % args.fixtures)
+    fixtures = [open(p, "rb").read() for p in paths]
+    if any(f[:2] != b"\xff\xd8" for f in fixtures):
+        sys.exit("fixtures must be baseline JPEGs")
+
+    stats = Stats()
+    server = ThreadingHTTPServer((args.host, args.port), make_handler(args, fixtures, stats))
+    print("Serving %d fixture(s) on http://%s:%d/" % (len(fixtures), args.host, args.port))
+    zc = advertise(args) if args.advertise else None
+    try:
+        server.serve_forever()
+    except KeyboardInterrupt:
+        pass
+    if zc:
+        zc.close()
+    print(json.dumps(stats.snapshot(), indent=1))
+
+
+if __name__ == "__main__":
+    main()
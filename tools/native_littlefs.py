@@ -0,0 +1,15 @@
+# native_littlefs.py — PlatformIO pre-script for the native_flash envs.
+# Builds only lfs.c and lfs_util.c, the core of littlefs, into the host
+# program. The library itself is lib_ignore'd because its repository also
+# holds test runners (with their own main()) and example block devices.
+
+import os
+
+Import("env")  # noqa: F821 (provided by SCons)
+
+libdir = os.path.join(env.subst("$PROJECT_LIBDEPS_DIR"), env.subst("$PIOENV"), "littlefs")
+if not os.path.isfile(os.path.join(libdir, "lfs.c")):
+    raise SystemExit("lfs.c not found in %s; run `pio pkg install -e %s` first" % (libdir, env.subst("$PIOENV")))
+
+env.Append(CPPPATH=[libdir])
+env.BuildSources(os.path.join("$BUILD_DIR", "littlefs"), libdir, src_filter="-<*> +<lfs.c> +<lfs_util.c>")
@@ -0,0 +1,15 @@
+# native_tjpgd.py — PlatformIO pre-script for the native_render envs.
+# Builds only tjpgd.c, the plain-C decoder core of bodmer/TJpg_Decoder, into
+# the host program. The library itself is lib_ignore'd because its Arduino
+# wrapper pulls in SD and FS headers a host build does not have.
+
+import os
+
+Import("env")  # noqa: F821 (provided by SCons)
+
+libdir = os.path.join(env.subst("$PROJECT_LIBDEPS_DIR"), env.subst("$PIOENV"), "TJpg_Decoder", "src")
+if not os.path.isfile(os.path.join(libdir, "tjpgd.c")):
+    raise SystemExit("tjpgd.c not found in %s; run `pio pkg install -e %s` first" % (libdir, env.subst("$PIOENV")))
+
+env.Append(CPPPATH=[libdir])
+env.BuildSources(os.path.join("$BUILD_DIR", "tjpgd"), libdir, src_filter="-<*> +<tjpgd.c>")